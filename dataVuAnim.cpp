@@ -0,0 +1,287 @@
+/******************************************************************************
+    This file implements the animation sequencer of the Data-Vu evaluation kit
+    library created by Plessey Semiconductors.
+
+    Copyright (C) 2019  <Gethn Pickard>
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <https://www.gnu.org/licenses/>.
+******************************************************************************/
+
+#include "dataVuAnim.h"
+
+// Period of the Timer0 compare interrupt. Arduino runs Timer0 at F_CPU/64 with a 256 count
+// period for millis(), which is 1024us at 16MHz.
+#define ANIM_TICK_US (64UL * 256 * 1000000 / F_CPU)
+
+// Sequencer playing, driven by update() or the Timer0 compare interrupt. Only one can run at
+// a time.
+static DataVuAnim *volatile activeAnim;
+
+/**
+    Frame clock of DATAVU_ANIM_ISR(). Runs alongside the millis() overflow interrupt on the
+    same timer.
+*/
+void DataVuAnim::tickActive() {
+    DataVuAnim *anim = activeAnim;
+    if (anim) {
+        anim->tick();
+    }
+}
+
+/**
+    Convert an eight bit timeline value to a frame buffer value
+*/
+static inline int animValue(uint8_t val) {
+    return val * DATAVU_VALUE_SCALE;
+}
+
+/**
+    Class constructor
+*/
+DataVuAnim::DataVuAnim(DataVuBase &dataVu) {
+    this->dataVu = &dataVu;
+    this->timeline = NULL;
+    this->active = false;
+    this->periodUs = 0;
+    this->rewind();
+}
+
+/**
+    Play a PROGMEM timeline from the start with a frame period in milliseconds
+*/
+void DataVuAnim::start(const uint8_t *timeline, uint16_t periodMs) {
+    this->stop();
+    this->timeline = timeline;
+    this->periodUs = periodMs * 1000UL;
+    this->seek(0);
+}
+
+/**
+    Stop the animation. The display keeps the last frame.
+*/
+void DataVuAnim::stop() {
+    uint8_t sreg = SREG;
+    cli();
+    if (activeAnim == this) {
+        if (dataVuAnimIsr) {
+            TIMSK0 &= ~(1 << OCIE0A);
+        }
+        activeAnim = NULL;
+    }
+    this->active = false;
+    SREG = sreg;
+}
+
+/**
+    Jump to a frame of the current timeline and continue playing from there
+*/
+void DataVuAnim::seek(uint16_t frame) {
+    if (this->timeline == NULL) {
+        return;
+    }
+    this->stop();
+
+    // Run the timeline without showing frames up to the requested one
+    this->rewind();
+    bool playing = this->step();
+    while (playing && this->frame < frame) {
+        playing = this->advance();
+    }
+    this->dataVu->writeFrameAsync();
+
+    // Hand over to the frame clock
+    if (playing) {
+        uint8_t sreg = SREG;
+        cli();
+        if (activeAnim) {
+            activeAnim->active = false;
+        }
+        activeAnim = this;
+        this->active = true;
+        this->tickUs = micros();
+        if (dataVuAnimIsr) {
+            TIFR0 = (1 << OCF0A);
+            TIMSK0 |= (1 << OCIE0A);
+        }
+        SREG = sreg;
+    }
+}
+
+/**
+    Check if the animation is playing
+*/
+bool DataVuAnim::running() {
+    return this->active;
+}
+
+/**
+    Number of frame periods since the start of the timeline
+*/
+uint16_t DataVuAnim::position() {
+    uint8_t sreg = SREG;
+    cli();
+    uint16_t frame = this->frame;
+    SREG = sreg;
+    return frame;
+}
+
+/**
+    Play the frames due since the last call. Call from loop() when the sketch does not use
+    DATAVU_ANIM_ISR().
+*/
+void DataVuAnim::update() {
+    if (dataVuAnimIsr) {
+        return;
+    }
+    while (this->active && (uint32_t)(micros() - this->tickUs) >= ANIM_TICK_US) {
+        this->tickUs += ANIM_TICK_US;
+        this->tick();
+    }
+}
+
+/**
+    Frame clock tick, every ANIM_TICK_US from update() or the Timer0 compare interrupt
+*/
+void DataVuAnim::tick() {
+
+    // Wait for the next frame period. The remainder carries over so the average rate is exact.
+    this->elapsedUs += ANIM_TICK_US;
+    if (this->elapsedUs < this->periodUs) {
+        return;
+    }
+    this->elapsedUs -= this->periodUs;
+
+    // Hold the current frame
+    this->frame++;
+    if (this->hold > 1) {
+        this->hold--;
+        return;
+    }
+
+    // Show the next frame, stop at the end of the timeline
+    if (not this->step()) {
+        this->stop();
+    }
+    this->dataVu->writeFrameAsync();
+}
+
+/**
+    Go back to the start of the timeline
+*/
+void DataVuAnim::rewind() {
+    this->pc = this->timeline;
+    this->elapsedUs = 0;
+    this->hold = 0;
+    this->frame = 0;
+    this->depth = 0;
+}
+
+/**
+    Move on one frame period. Returns false at the end of the timeline.
+*/
+bool DataVuAnim::advance() {
+    this->frame++;
+    if (this->hold > 1) {
+        this->hold--;
+        return true;
+    }
+    return this->step();
+}
+
+/**
+    Run timeline ops up to the next hold. Returns false at the end of the timeline.
+    A loop must contain a hold.
+*/
+bool DataVuAnim::step() {
+    while (true) {
+        uint8_t op = pgm_read_byte(this->pc++);
+        switch (op) {
+
+            case ANIM_OP_FILL: {
+                this->dataVu->updateFrame(animValue(pgm_read_byte(this->pc++)));
+                break;
+            }
+
+            case ANIM_OP_SET: {
+                uint8_t symbol = pgm_read_byte(this->pc++);
+                uint8_t val = pgm_read_byte(this->pc++);
+                this->dataVu->updateSymbol(symbol, animValue(val));
+                break;
+            }
+
+            case ANIM_OP_ADD: {
+                uint8_t symbol = pgm_read_byte(this->pc++);
+                int8_t delta = pgm_read_byte(this->pc++);
+                if (symbol < SYMBOL_COUNT) {
+                    int val = this->dataVu->getSymbol(symbol) + delta * DATAVU_VALUE_SCALE;
+                    this->dataVu->updateSymbol(symbol, constrain(val, 0, DATAVU_VALUE_MAX));
+                }
+                break;
+            }
+
+            case ANIM_OP_DIGIT: {
+                char c = pgm_read_byte(this->pc++);
+                uint8_t digit = pgm_read_byte(this->pc++);
+                uint8_t val = pgm_read_byte(this->pc++);
+                this->dataVu->updateDigit(c, digit, animValue(val));
+                break;
+            }
+
+            case ANIM_OP_KEYFRAME: {
+                for (int i = 0; i < SYMBOL_COUNT; i++) {
+                    this->dataVu->updateSymbol(i, animValue(pgm_read_byte(this->pc++)));
+                }
+                break;
+            }
+
+            case ANIM_OP_HOLD: {
+                this->hold = pgm_read_byte(this->pc++);
+                if (this->hold == 0) {
+                    this->hold = 1;
+                }
+                return true;
+            }
+
+            case ANIM_OP_LOOP: {
+                uint8_t count = pgm_read_byte(this->pc++);
+                if (this->depth < ANIM_LOOP_DEPTH) {
+                    this->loops[this->depth].start = this->pc;
+                    this->loops[this->depth].left = count;
+                    this->depth++;
+                }
+                break;
+            }
+
+            case ANIM_OP_ENDLOOP: {
+                if (this->depth > 0) {
+                    uint8_t d = this->depth - 1;
+                    if (this->loops[d].left == 0 || --this->loops[d].left > 0) {
+                        this->pc = this->loops[d].start;
+                    }
+                    else {
+                        this->depth = d;
+                    }
+                }
+                break;
+            }
+
+            default: {
+
+                // ANIM_OP_END or an unknown op
+                this->pc--;
+                return false;
+            }
+        }
+    }
+}
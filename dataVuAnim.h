@@ -0,0 +1,108 @@
+/******************************************************************************
+    This file is the header file for the animation sequencer of the Data-Vu
+    evaluation kit library created by Plessey Semiconductors.
+
+    Copyright (C) 2019  <Gethn Pickard>
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <https://www.gnu.org/licenses/>.
+******************************************************************************/
+
+#ifndef DATAVUANIM_H
+#define DATAVUANIM_H
+
+#include "dataVuLib.h"
+
+// Deepest nesting of ANIM_LOOP
+#define ANIM_LOOP_DEPTH 4
+
+// Timeline op codes
+#define ANIM_OP_END         0x00
+#define ANIM_OP_FILL        0x01
+#define ANIM_OP_SET         0x02
+#define ANIM_OP_ADD         0x03
+#define ANIM_OP_DIGIT       0x04
+#define ANIM_OP_KEYFRAME    0x05
+#define ANIM_OP_HOLD        0x06
+#define ANIM_OP_LOOP        0x07
+#define ANIM_OP_ENDLOOP     0x08
+
+/*
+    Timeline authoring macros. A timeline is a PROGMEM byte array of these. Values are
+    eight bit (0-255) like the firmware CLI. Ops change the frame buffer until an
+    ANIM_HOLD, which shows the frame for a number of frame periods.
+
+        const uint8_t blink[] PROGMEM = {
+            ANIM_LOOP(0),
+                ANIM_FILL(255), ANIM_HOLD(5),
+                ANIM_FILL(0),   ANIM_HOLD(5),
+            ANIM_ENDLOOP(),
+            ANIM_END()
+        };
+*/
+#define ANIM_END()              ANIM_OP_END                             // Stop the animation
+#define ANIM_FILL(val)          ANIM_OP_FILL, (val)                     // Set every symbol
+#define ANIM_SET(sym, val)      ANIM_OP_SET, (sym), (val)               // Set one symbol
+#define ANIM_ADD(sym, delta)    ANIM_OP_ADD, (sym), (uint8_t)(delta)    // Add -128 to 127 to one symbol
+#define ANIM_DIGIT(c, dig, val) ANIM_OP_DIGIT, (c), (dig), (val)        // Set a seven segment digit
+#define ANIM_KEYFRAME()         ANIM_OP_KEYFRAME                        // Followed by SYMBOL_COUNT values
+#define ANIM_HOLD(frames)       ANIM_OP_HOLD, (frames)                  // Show the frame for 1-255 frames
+#define ANIM_SHOW()             ANIM_HOLD(1)                            // Show the frame for one frame
+#define ANIM_LOOP(count)        ANIM_OP_LOOP, (count)                   // Repeat to ANIM_ENDLOOP, 0 forever
+#define ANIM_ENDLOOP()          ANIM_OP_ENDLOOP
+
+/*
+    Put DATAVU_ANIM_ISR() in the sketch to run animations from the Timer0 compare A interrupt.
+    The library does not take the vector otherwise, and animations run from update() called
+    in loop().
+*/
+void dataVuAnimIsr(void) __attribute__((weak));
+#define DATAVU_ANIM_ISR() \
+    void dataVuAnimIsr(void) { DataVuAnim::tickActive(); } \
+    ISR(TIMER0_COMPA_vect) { dataVuAnimIsr(); }
+
+class DataVuAnim
+{
+        DataVuBase *dataVu;
+        const uint8_t *timeline;
+        const uint8_t *pc;
+        volatile bool active;
+        uint32_t periodUs;
+        uint32_t elapsedUs;
+        uint32_t tickUs;
+        uint8_t hold;
+        uint16_t frame;
+        uint8_t depth;
+        struct {
+            const uint8_t *start;
+            uint8_t left;
+        } loops[ANIM_LOOP_DEPTH];
+
+    public:
+        DataVuAnim(DataVuBase&);
+        void start(const uint8_t*, uint16_t);
+        void stop();
+        void seek(uint16_t);
+        bool running();
+        uint16_t position();
+        void update();
+        void tick();
+        static void tickActive();
+
+    private:
+        void rewind();
+        bool step();
+        bool advance();
+};
+
+#endif //DATAVUANIM_H
@@ -0,0 +1,36 @@
+/******************************************************************************
+    This file holds the build options of the Data-Vu evaluation kit library
+    created by Plessey Semiconductors.
+
+    Copyright (C) 2019  <Gethn Pickard>
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <https://www.gnu.org/licenses/>.
+******************************************************************************/
+
+/*
+    Library options, see Pre-processor Definitions in the README. The Arduino IDE compiles the
+    library apart from the sketch, so an option defined in the sketch does not reach it. Define
+    options here instead, where they apply to every sketch, or pass them to the compiler with
+    -D but not both.
+*/
+
+#ifndef DATAVUCONFIG_H
+#define DATAVUCONFIG_H
+
+// e.g.
+// #define DATAVU_ASYNC 1
+// #define DATAVU_PACKED_FRAME 1
+// #define DATAVU_GAMMA DATAVU_GAMMA_CIE1931
+
+#endif //DATAVUCONFIG_H
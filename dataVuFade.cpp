@@ -0,0 +1,242 @@
+/******************************************************************************
+    This file implements the cross-fade engine of the Data-Vu evaluation kit
+    library created by Plessey Semiconductors.
+
+    Copyright (C) 2019  <Gethn Pickard>
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <https://www.gnu.org/licenses/>.
+******************************************************************************/
+
+#include "dataVuFade.h"
+
+// Period of the Timer0 compare interrupt, 1024us at 16MHz. See dataVuAnim.cpp.
+#define FADE_TICK_US (64UL * 256 * 1000000 / F_CPU)
+
+/*
+    Easing curves, 33 points over the fade with values 0-255. Progress between points is
+    interpolated.
+*/
+const uint8_t EASE_IN[33] PROGMEM = {           // x^2
+    0, 0, 1, 2, 4, 6, 9, 12, 16, 20, 25, 30, 36, 42, 49, 56, 64,
+    72, 81, 90, 100, 110, 121, 132, 143, 156, 168, 182, 195, 209, 224, 239, 255
+};
+const uint8_t EASE_OUT[33] PROGMEM = {          // 1 - (1 - x)^2
+    0, 16, 31, 46, 60, 73, 87, 99, 112, 123, 134, 145, 155, 165, 174, 183, 191,
+    199, 206, 213, 219, 225, 230, 235, 239, 243, 246, 249, 251, 253, 254, 255, 255
+};
+const uint8_t EASE_IN_OUT[33] PROGMEM = {       // 3x^2 - 2x^3
+    0, 1, 3, 6, 11, 17, 24, 31, 40, 49, 59, 70, 81, 92, 104, 116, 128,
+    139, 151, 163, 174, 185, 196, 206, 215, 224, 231, 238, 244, 249, 252, 254, 255
+};
+
+// Fade running, driven by update() or the Timer0 compare interrupt. Only one can run at a time.
+static DataVuFade *volatile activeFade;
+
+/**
+    Frame clock of DATAVU_FADE_ISR(). Runs alongside the millis() overflow interrupt on the
+    same timer.
+*/
+void DataVuFade::tickActive() {
+    DataVuFade *fade = activeFade;
+    if (fade) {
+        fade->tick();
+    }
+}
+
+/**
+    Class constructor
+*/
+DataVuFade::DataVuFade(DataVuBase &dataVu) {
+    this->dataVu = &dataVu;
+    this->active = false;
+}
+
+/**
+    Fade every symbol from its current value to a new frame
+*/
+int DataVuFade::fadeTo(const int target[SYMBOL_COUNT], uint16_t durationMs, uint8_t curve, uint16_t periodMs) {
+
+    // Check for input errors
+    for (int i = 0; i < SYMBOL_COUNT; i++) {
+        if (target[i] < 0 || target[i] > DATAVU_VALUE_MAX) {
+            return 1;
+        }
+    }
+    this->stop();
+
+    // Start point and distance of each symbol
+    for (int i = 0; i < SYMBOL_COUNT; i++) {
+        this->startVal[i] = this->dataVu->getSymbol(i);
+        this->delta[i] = target[i] - this->startVal[i];
+    }
+    this->begin(durationMs, curve, periodMs);
+
+    // Completed successfully
+    return 0;
+}
+
+/**
+    Fade every symbol from its current value to a common value
+*/
+int DataVuFade::fadeAllTo(int val, uint16_t durationMs, uint8_t curve, uint16_t periodMs) {
+
+    // Check for input errors
+    if (val < 0 || val > DATAVU_VALUE_MAX) {
+        return 1;
+    }
+    this->stop();
+
+    // Start point and distance of each symbol
+    for (int i = 0; i < SYMBOL_COUNT; i++) {
+        this->startVal[i] = this->dataVu->getSymbol(i);
+        this->delta[i] = val - this->startVal[i];
+    }
+    this->begin(durationMs, curve, periodMs);
+
+    // Completed successfully
+    return 0;
+}
+
+/**
+    Stop the fade. The display keeps the last frame.
+*/
+void DataVuFade::stop() {
+    uint8_t sreg = SREG;
+    cli();
+    if (activeFade == this) {
+        if (dataVuFadeIsr) {
+            TIMSK0 &= ~(1 << OCIE0B);
+        }
+        activeFade = NULL;
+    }
+    this->active = false;
+    SREG = sreg;
+}
+
+/**
+    Check if a fade is in progress
+*/
+bool DataVuFade::running() {
+    return this->active;
+}
+
+/**
+    Run the frame clock ticks due since the last call. Call from loop() unless the sketch uses
+    DATAVU_FADE_ISR().
+*/
+void DataVuFade::update() {
+    if (dataVuFadeIsr) {
+        return;
+    }
+    while (this->active && (uint32_t)(micros() - this->tickUs) >= FADE_TICK_US) {
+        this->tickUs += FADE_TICK_US;
+        this->tick();
+    }
+}
+
+/**
+    Frame clock tick, every FADE_TICK_US from update() or the Timer0 compare interrupt
+*/
+void DataVuFade::tick() {
+
+    // Wait for the next frame period
+    this->elapsedUs += FADE_TICK_US;
+    if (this->elapsedUs < this->periodUs) {
+        return;
+    }
+    this->elapsedUs -= this->periodUs;
+
+    // Progress runs 0-256 over the fade. Each frame adds 256 * periodMs / durationMs, kept
+    // exact with a Bresenham accumulator instead of a divide.
+    this->progressAcc += 256UL * this->periodMs;
+    while (this->progressAcc >= this->durationMs && this->progress < 256) {
+        this->progressAcc -= this->durationMs;
+        this->progress++;
+    }
+
+    // A frame due during a blocking write in loop() is sent as that write releases the bus,
+    // without DATAVU_ASYNC as well
+    this->render();
+    this->dataVu->writeFrameAsync();
+}
+
+/**
+    Start the frame clock for a fade set up by fadeTo or fadeAllTo
+*/
+void DataVuFade::begin(uint16_t durationMs, uint8_t curve, uint16_t periodMs) {
+    switch (curve) {
+        case FADE_EASE_IN:      this->curve = EASE_IN; break;
+        case FADE_EASE_OUT:     this->curve = EASE_OUT; break;
+        case FADE_EASE_IN_OUT:  this->curve = EASE_IN_OUT; break;
+        default:                this->curve = NULL; break;
+    }
+    this->periodMs = periodMs > 0 ? periodMs : 1;
+    this->periodUs = this->periodMs * 1000UL;
+    this->durationMs = durationMs;
+    this->elapsedUs = 0;
+    this->progressAcc = 0;
+    this->progress = 0;
+
+    // Nothing to fade
+    if (durationMs == 0) {
+        this->progress = 256;
+        this->render();
+        this->dataVu->writeFrameAsync();
+        return;
+    }
+
+    // Hand over to the frame clock
+    uint8_t sreg = SREG;
+    cli();
+    if (activeFade) {
+        activeFade->active = false;
+    }
+    activeFade = this;
+    this->active = true;
+    this->tickUs = micros();
+    if (dataVuFadeIsr) {
+        TIFR0 = (1 << OCF0B);
+        TIMSK0 |= (1 << OCIE0B);
+    }
+    SREG = sreg;
+}
+
+/**
+    Update the frame buffer for the current progress. One multiply per symbol.
+*/
+void DataVuFade::render() {
+
+    // Last frame lands exactly on the target
+    if (this->progress >= 256) {
+        for (int i = 0; i < SYMBOL_COUNT; i++) {
+            this->dataVu->updateSymbol(i, this->startVal[i] + this->delta[i]);
+        }
+        this->stop();
+        return;
+    }
+
+    // Eased progress 0-255, interpolated between curve points
+    uint8_t ease = this->progress;
+    if (this->curve) {
+        uint8_t i = this->progress >> 3;
+        uint8_t a = pgm_read_byte(&this->curve[i]);
+        uint8_t b = pgm_read_byte(&this->curve[i + 1]);
+        ease = a + (((b - a) * (this->progress & 7)) >> 3);
+    }
+
+    for (int i = 0; i < SYMBOL_COUNT; i++) {
+        int16_t step = ((int32_t)this->delta[i] * ease) >> 8;
+        this->dataVu->updateSymbol(i, this->startVal[i] + step);
+    }
+}
@@ -0,0 +1,75 @@
+/******************************************************************************
+    This file is the header file for the cross-fade engine of the Data-Vu
+    evaluation kit library created by Plessey Semiconductors.
+
+    Copyright (C) 2019  <Gethn Pickard>
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <https://www.gnu.org/licenses/>.
+******************************************************************************/
+
+#ifndef DATAVUFADE_H
+#define DATAVUFADE_H
+
+#include "dataVuLib.h"
+
+// Easing curves
+#define FADE_LINEAR         0
+#define FADE_EASE_IN        1
+#define FADE_EASE_OUT       2
+#define FADE_EASE_IN_OUT    3
+
+// Default time between faded frames in milliseconds
+#define FADE_PERIOD 20
+
+/*
+    Put DATAVU_FADE_ISR() in the sketch to render fades from the Timer0 compare B interrupt.
+    The library does not take the vector otherwise, and fades run from update() called in
+    loop().
+*/
+void dataVuFadeIsr(void) __attribute__((weak));
+#define DATAVU_FADE_ISR() \
+    void dataVuFadeIsr(void) { DataVuFade::tickActive(); } \
+    ISR(TIMER0_COMPB_vect) { dataVuFadeIsr(); }
+
+class DataVuFade
+{
+        DataVuBase *dataVu;
+        int16_t startVal[SYMBOL_COUNT];
+        int16_t delta[SYMBOL_COUNT];
+        const uint8_t *curve;
+        volatile bool active;
+        uint32_t periodUs;
+        uint32_t elapsedUs;
+        uint32_t tickUs;
+        uint16_t periodMs;
+        uint16_t durationMs;
+        uint32_t progressAcc;
+        uint16_t progress;
+
+    public:
+        DataVuFade(DataVuBase&);
+        int fadeTo(const int*, uint16_t, uint8_t curve = FADE_LINEAR, uint16_t periodMs = FADE_PERIOD);
+        int fadeAllTo(int, uint16_t, uint8_t curve = FADE_LINEAR, uint16_t periodMs = FADE_PERIOD);
+        void stop();
+        bool running();
+        void update();
+        void tick();
+        static void tickActive();
+
+    private:
+        void begin(uint16_t, uint8_t, uint16_t);
+        void render();
+};
+
+#endif //DATAVUFADE_H
@@ -19,16 +19,300 @@
 ******************************************************************************/
 
 #include "dataVuLib.h"
+#include <util/crc16.h>
+
+// Callback run once a frame has been latched by writeFrameAsync
+static void (*volatile txCallback)(void);
+
+#if DATAVU_ASYNC
+
+// Transmission engine state. Timer1 is shared, so there is one engine for all objects.
+static uint8_t txBuf[2][PACKED_FRAME_SIZE];     // Front and back frame buffers
+static const uint8_t *volatile txPtr;           // Next byte to shift
+static volatile uint8_t txFront;                // Buffer being shifted
+static volatile bool txBusy;                    // Bus is in use
+static volatile bool txPending;                 // Back buffer is queued
+static volatile bool txFilling;                 // Back buffer is being written
+static volatile bool txRefill;                  // Back buffer is stale
+static DataVuBase *volatile txChain[2];         // Chain each buffer is shifted to
+static void (*volatile txShift[2])(const uint8_t*, int);    // Its shift function, for the interrupt
+
+#else
+
+// Without the engine writeFrameAsync shifts straight away. One called from an interrupt
+// during a blocking write is left to that write to send as it releases the bus.
+static volatile bool busBusy;                   // A blocking write is shifting
+static DataVuBase *volatile busDeferred;        // Chain whose frame is waiting for the bus
+
+#endif
+
+// Timer2 prescaler of each clock select value, 0 when stopped
+static const uint16_t TIMER2_PRESCALE[8] PROGMEM = {0, 1, 8, 32, 64, 128, 256, 1024};
+
+// Timer2 TOP set for PCLK. Timer2 is shared, so every object runs from the same PCLK.
+static volatile uint8_t pclkTop;
+
+#if DATAVU_PWM_DITHER
+
+// PCLK dither state. OCR2A sweeps pclkTop +/- ditherDepth, one step per Timer1 overflow.
+static volatile int8_t ditherDepth;
+static int8_t ditherOffset;
+static int8_t ditherDir = 1;
+
+/**
+    Step OCR2A along its sweep. OCR2A and OCR2B are double buffered in fast PWM mode, so the
+    new period starts cleanly at the next BOTTOM.
+*/
+static inline void ditherPclk() {
+    int8_t depth = ditherDepth;
+    if (depth == 0) {
+        return;
+    }
+    int8_t offset = ditherOffset + ditherDir;
+    if (offset >= depth || offset <= -depth) {
+        ditherDir = -ditherDir;
+    }
+    ditherOffset = offset;
+    uint8_t top = pclkTop + offset;
+    OCR2A = top;
+    OCR2B = top >> 1;
+}
+
+#endif
+
+/**
+    Turn the Timer1 overflow interrupt off unless the transmission engine or PCLK dither still
+    need it. Call with interrupts off.
+*/
+static inline void releaseTimer1() {
+#if DATAVU_PWM_DITHER
+    if (ditherDepth) {
+        return;
+    }
+#endif
+#if DATAVU_ASYNC
+    if (txPtr) {
+        return;
+    }
+#endif
+    TIMSK1 &= ~(1 << TOIE1);
+}
+
+/**
+    CPU cycles per PCLK cycle, 0 when Timer2 is stopped
+*/
+static uint32_t pclkCycles() {
+    return pgm_read_word(&TIMER2_PRESCALE[TCCR2B & 7]) * (pclkTop + 1UL);
+}
+
+/**
+    Run PCLK from Timer2 in fast PWM mode with OCR2A as TOP, F_CPU / (prescale * (top + 1)).
+    The timer is stopped in normal mode while OCR2A and OCR2B are written, which are only
+    double buffered in the PWM modes.
+*/
+static void startPclk(uint8_t cs, uint8_t top) {
+    uint8_t sreg = SREG;
+    cli();
+    TCCR2B = 0;
+    TCCR2A = 0;
+    pclkTop = top;
+    OCR2A = top;
+    OCR2B = top >> 1;
+    TCNT2 = 0;
+    TCCR2A = (1 << COM2B1) | (1 << WGM21) | (1 << WGM20);
+    TCCR2B = (1 << WGM22) | cs;
+    
+#if DATAVU_PWM_DITHER
+    // Keep the sweep within 1-255
+    int8_t limit = top - 1 < 255 - top ? top - 1 : 255 - top;
+    if (ditherDepth > limit) {
+        ditherDepth = limit;
+    }
+    ditherOffset = 0;
+    releaseTimer1();
+#endif
+    SREG = sreg;
+}
+
+#if DATAVU_GAMMA
+
+/**
+    Twelve bit PWM value for an eight bit frame buffer value
+*/
+#if DATAVU_GAMMA == DATAVU_GAMMA_LINEAR
+constexpr uint16_t gammaValue(uint32_t x) {
+    return (x * 4095 + 127) / 255;
+}
+#elif DATAVU_GAMMA == DATAVU_GAMMA_SQUARE
+constexpr uint16_t gammaValue(uint32_t x) {
+    return (x * x * 4095 + 65025 / 2) / 65025;
+}
+#elif DATAVU_GAMMA == DATAVU_GAMMA_CUBE
+constexpr uint16_t gammaValue(unsigned long long x) {
+    return (x * x * x * 4095 + 16581375 / 2) / 16581375;
+}
+#elif DATAVU_GAMMA == DATAVU_GAMMA_CIE1931
+constexpr double cieLuminance(double l) {
+    return l <= 8 ? l / 903.3 : ((l + 16) / 116) * ((l + 16) / 116) * ((l + 16) / 116);
+}
+constexpr uint16_t gammaValue(uint32_t x) {
+    return cieLuminance(x * 100.0 / 255) * 4095 + 0.5;
+}
+#else
+#error "Unknown DATAVU_GAMMA curve"
+#endif
+
+#define GAMMA4(i)   gammaValue(i), gammaValue(i + 1), gammaValue(i + 2), gammaValue(i + 3)
+#define GAMMA16(i)  GAMMA4(i), GAMMA4(i + 4), GAMMA4(i + 8), GAMMA4(i + 12)
+#define GAMMA64(i)  GAMMA16(i), GAMMA16(i + 16), GAMMA16(i + 32), GAMMA16(i + 48)
+
+// Gamma table, built by the compiler
+constexpr uint16_t GAMMA_LUT[256] PROGMEM = {
+    GAMMA64(0), GAMMA64(64), GAMMA64(128), GAMMA64(192)
+};
+static_assert(GAMMA_LUT[0] == 0 && GAMMA_LUT[255] == 4095, "Gamma table must span the PWM range");
+
+#endif
+
+/**
+    Multiplier of the master brightness, out of 256. 0 is off and 255 full, b + b / 128 keeps
+    the steps between even.
+*/
+static inline uint16_t brightnessScale(uint8_t brightness) {
+    return brightness + (brightness >> 7);
+}
+
+/**
+    PWM value to shift for a frame buffer value. scale is from brightnessScale, 256 for full.
+*/
+static inline uint16_t pwmValue(uint16_t val, uint16_t scale) {
+#if DATAVU_GAMMA
+    val = pgm_read_word(&GAMMA_LUT[(uint8_t)val]);
+#else
+    val = fromFrame(val);
+#endif
+    if (scale < 256) {
+        val = ((uint32_t)val * scale) >> 8;
+    }
+    return val;
+}
+
+/**
+    Frame value of a PWM channel, 0 for an unused channel (symbol -1). Unused channels read
+    symbol 0 and mask the value off, so the serializer has no branch per channel.
+*/
+static inline uint16_t channelValue(const frame_t *frame, int16_t symbol) {
+    int16_t used = ~(symbol >> 15);
+    return frame[symbol & used] & used;
+}
+
+#if DATAVU_ASYNC
+
+/**
+    Start shifting the back buffer if queued, otherwise release the bus. Call with interrupts off.
+*/
+static void txNext() {
+    if (txPending) {
+        txPending = false;
+        txFront ^= 1;
+        txPtr = txBuf[txFront];
+        TIMSK1 |= (1 << TOIE1);
+    }
+    else {
+        txBusy = false;
+        txPtr = NULL;
+        releaseTimer1();
+    }
+}
+
+/**
+    Transmission engine. Shifts one byte per Timer1 overflow to the chain that queued the frame
+    and latches at the end of the frame.
+*/
+void DataVuBase::txService() {
+    const uint8_t *p = txPtr;
+    const uint8_t *end = txBuf[txFront] + PACKED_FRAME_SIZE;
+    if (p != end) {
+        txShift[txFront](p++, 1);
+        txPtr = p;
+    }
+    
+    // A latch DATAVU_LATCH_SYNC holds back is tried again at the next overflow, not waited
+    // for in the interrupt
+    if (p == end && txChain[txFront]->latchWhenClear() == 0) {
+        txNext();
+        if (txCallback) {
+            txCallback();
+        }
+    }
+}
+
+#endif
+
+#if DATAVU_ASYNC || DATAVU_PWM_DITHER
+
+ISR(TIMER1_OVF_vect) {
+#if DATAVU_PWM_DITHER
+    ditherPclk();
+#endif
+#if DATAVU_ASYNC
+    if (txPtr) {
+        DataVuBase::txService();
+    }
+#endif
+}
+
+#endif
+
+/**
+    Wait for the transmission engine to finish and claim the bus for a blocking write
+*/
+static inline void acquireBus() {
+#if DATAVU_ASYNC
+    while (true) {
+        uint8_t sreg = SREG;
+        cli();
+        if (not txBusy) {
+            txBusy = true;
+            SREG = sreg;
+            return;
+        }
+        SREG = sreg;
+    }
+#else
+    busBusy = true;
+#endif
+}
+
+/**
+    Release the bus after a blocking write, starting any frame queued in the meantime
+*/
+static inline void releaseBus() {
+#if DATAVU_ASYNC
+    uint8_t sreg = SREG;
+    cli();
+    txNext();
+    SREG = sreg;
+#else
+    uint8_t sreg = SREG;
+    cli();
+    DataVuBase *deferred = busDeferred;
+    busDeferred = NULL;
+    busBusy = false;
+    SREG = sreg;
+    if (deferred) {
+        deferred->writeFrameAsync();
+    }
+#endif
+}
 
 /**
     Class constructor
 */
-DataVu::DataVu(void) {
+DataVuBase::DataVuBase(const DataVuPinOps &pins) {
+    this->pins = pins;
     
-    // Setup pins
-    pinMode(PWM_SCKI,OUTPUT);
-    pinMode(PWM_SDI, OUTPUT);
-    pinMode(PWM_LATCH, OUTPUT);
+    // Setup pins. The serial pins are set up by DataVuChain.
     pinMode(PWM_PCLK, OUTPUT); 
     pinMode(PWM_SDO, INPUT);
     pinMode(DAC, OUTPUT);
@@ -38,47 +322,206 @@ DataVu::DataVu(void) {
     pinMode(BTN4, INPUT);
 
     // Set pins initial states
-    digitalWrite(PWM_SCKI, LOW);
-    digitalWrite(PWM_SDI, LOW);
-    digitalWrite(PWM_LATCH, LOW);
     digitalWrite(PWM_PCLK, LOW); 
     digitalWrite(DAC, LOW);
+    
+    // Display contents are unknown until the first write
+    this->frameDirty = true;
+    this->skippedWrites = 0;
+    this->verifyErrors = 0;
+    this->brightness = 255;
+    this->calProfile = 0;
+    
+    // Chips are taken to be at their power on state until begin resets them
+    this->chipConfig = CHIP_RESET_CONFIG;
+    this->wantConfig = CHIP_DEFAULT_CONFIG;
+    this->calSet = false;
+    this->calLoaded = false;
+    
+#if DATAVU_PACKED_FRAME
+    // Build inverse of the symbol map
+    for (int i = 0; i < SYMBOL_COUNT; i++) {
+        this->symbolChannel[i] = NO_CHANNEL;
+    }
+    for (int i = 0; i < PWM_CHANNEL_COUNT; i++) {
+        int16_t symbol = readSymbol(&SYMBOL_MAP[i]);
+        if (symbol >= 0) {
+            this->symbolChannel[symbol] = i;
+        }
+    }
+    
+    // Clear packed frame and set the command byte of each chip
+    for (int i = 0; i < PACKED_FRAME_SIZE; i++) {
+        this->frameBits[i] = 0;
+    }
+    for (int chip = 1; chip <= LT8500_COUNT; chip++) {
+        this->frameBits[chip * CHIP_FRAME_SIZE - 1] = UPDATE_PWM_CMD;
+    }
+#endif
 }
 
+// Calibration record header: magic, version, display tag and sequence number. The magic is
+// never a byte of the old int array format, whose values are 0 to 63.
+#define CAL_MAGIC   0xCA
+#define SPLASH_MAGIC 0x5A
+#define CAL_VERSION 1
+
 /**
-    Initializes the DataVu object
+    Tag of the display a record was saved for, a hash of the display type and symbol count
 */
-void DataVu::begin(void) {
-    
-    // Setup PWM_PCLK
-    OCR2B = 0;
-    OCR2A = 0;
-    TCCR2A = 0;
-    TCCR2B = 0;
-    TCCR2A |= (1 << COM2B0) | (1 << WGM21);
-    TCCR2B |= (1 << CS20);
+constexpr uint8_t calTag(const char *s, uint8_t h) {
+    return *s ? calTag(s + 1, (uint8_t)(h * 31 + *s)) : h;
+}
+#define CAL_TAG calTag(DISPLAY_TYPE, (uint8_t)(SYMBOL_COUNT ^ (SYMBOL_COUNT >> 8)))
 
-    // Initialise frame buffer to zeros
-    this->updateFrame(0);
+static_assert(CALIBRATION_ADDR + CAL_STORE_SIZE <= E2END + 1, "Calibration store does not fit in the EEPROM");
+static_assert(SPLASH_ADDR + SPLASH_SIZE <= E2END + 1, "Splash frame does not fit in the EEPROM");
+static_assert(CAL_SLOT_COUNT >= 1 && CAL_SLOT_COUNT <= 8, "CAL_SLOT_COUNT must be 1 to 8");
 
-    // Setup PWM chips
-    this->resetChips();
+/**
+    EEPROM address of a calibration record
+*/
+static inline int calAddr(uint8_t profile, uint8_t slot) {
+    return CALIBRATION_ADDR + (profile * CAL_SLOT_COUNT + slot) * CAL_RECORD_SIZE;
+}
+
+/**
+    Newest slot of a profile with a record header for this display, -1 for none. Slots set in
+    the skip mask are ignored.
+*/
+static int8_t newestCal(uint8_t profile, uint8_t skip) {
+    int8_t newest = -1;
+    uint8_t newestSeq = 0;
+    for (uint8_t slot = 0; slot < CAL_SLOT_COUNT; slot++) {
+        int addr = calAddr(profile, slot);
+        if ((skip >> slot) & 1 || EEPROM.read(addr) != CAL_MAGIC || EEPROM.read(addr + 1) != CAL_VERSION || EEPROM.read(addr + 2) != CAL_TAG) {
+            continue;
+        }
+        
+        // Sequence numbers wrap, the newer is ahead by less than half the range
+        uint8_t seq = EEPROM.read(addr + 3);
+        if (newest < 0 || (int8_t)(seq - newestSeq) > 0) {
+            newest = slot;
+            newestSeq = seq;
+        }
+    }
+    return newest;
+}
+
+/**
+    Read a calibration record. Returns false if the CRC does not match, cal and name are then
+    undefined. Either may be NULL.
+*/
+static bool readCalRecord(int addr, int *cal, char *name) {
     
-    // Read and update calibration data from EEPROM
-    int cal[SYMBOL_COUNT];
-    EEPROM.get(CALIBRATION_ADDR, cal);
-    this->writeCal(cal);
+    // Header and name
+    uint16_t crc = 0xFFFF;
+    for (uint8_t i = 0; i < CAL_HEADER_SIZE + CAL_NAME_SIZE; i++) {
+        uint8_t b = EEPROM.read(addr++);
+        crc = _crc_ccitt_update(crc, b);
+        if (name && i >= CAL_HEADER_SIZE) {
+            name[i - CAL_HEADER_SIZE] = b;
+        }
+    }
+    if (name) {
+        name[CAL_NAME_SIZE] = '\0';
+    }
+    
+    // Unpack six bit values, four to three bytes
+    uint16_t bits = 0;
+    uint8_t count = 0;
+    int i = 0;
+    for (int n = 0; n < CAL_DATA_SIZE; n++) {
+        uint8_t b = EEPROM.read(addr++);
+        crc = _crc_ccitt_update(crc, b);
+        bits = (bits << 8) | b;
+        count += 8;
+        while (count >= 6 && i < SYMBOL_COUNT) {
+            count -= 6;
+            if (cal) {
+                cal[i] = (bits >> count) & 0x3F;
+            }
+            i++;
+        }
+    }
+    
+    // CRC, low byte first
+    return EEPROM.read(addr) == (crc & 0xFF) && EEPROM.read(addr + 1) == (crc >> 8);
+}
+
+/**
+    Write a byte of a calibration record, only if it changed
+*/
+static uint16_t writeCalByte(int &addr, uint8_t b, uint16_t crc) {
+    EEPROM.update(addr++, b);
+    return _crc_ccitt_update(crc, b);
+}
+
+/**
+    Pack six bit calibration values, four to three bytes
+*/
+static void packCal(const int cal[SYMBOL_COUNT], uint8_t packed[CAL_DATA_SIZE]) {
+    uint16_t bits = 0;
+    uint8_t count = 0;
+    for (int i = 0; i < SYMBOL_COUNT; i++) {
+        bits = (bits << 6) | cal[i];
+        count += 6;
+        if (count >= 8) {
+            count -= 8;
+            *packed++ = bits >> count;
+        }
+    }
+    if (count) {
+        *packed = bits << (8 - count);
+    }
+}
+
+/**
+    Six bit calibration value of a symbol from packed values
+*/
+static inline uint8_t unpackCal(const uint8_t packed[CAL_DATA_SIZE], int symbol) {
+    int bit = symbol * 6;
+    uint8_t offset = bit & 7;
+    uint16_t two = packed[bit >> 3] << 8;
+    if (offset > 2) {
+        two |= packed[(bit >> 3) + 1];
+    }
+    return (two >> (10 - offset)) & 0x3F;
+}
 
-    // Setup PWM for the DAC
+/**
+    Initializes the DataVu object
+*/
+void DataVuBase::begin(void) {
+    
+    // Setup PWM for the DAC first so its filter settles while the chips are set up
     OCR1A = 0;
     TCCR1A |= (1 << COM1A1) | (1 << WGM10);
     TCCR1B |= (1 << CS10) | (1 << WGM12); 
+    
+    // Setup PWM_PCLK at F_CPU / 2
+    startPclk(1 << CS20, 1);
+
+    // Initialise frame buffer to the splash frame and its voltage, otherwise zeros
+    if (not this->readSplash()) {
+        this->updateFrame(0);
+    }
+
+    // Setup PWM chips, which then show the frame buffer
+    this->resetChips();
+    
+    // Read and update calibration data from EEPROM. The chips keep their reset values when
+    // there is no valid record.
+    int cal[SYMBOL_COUNT];
+    if (this->readCal(cal, this->calProfile) == 0) {
+        this->writeCal(cal);
+    }
 }
 
 /**
     Sets the LED anode voltage
 */
-int DataVu::setVoltage(float voltage) {
+int DataVuBase::setVoltage(float voltage) {
     
     // Check voltage is within range
     if (voltage > MAX_VOLTAGE || voltage < 0) {
@@ -95,19 +538,33 @@ int DataVu::setVoltage(float voltage) {
     return 0;
 }
 
+/**
+    Store a frame buffer entry, marking the frame dirty if it changed. Symbol must be in range.
+*/
+inline void DataVuBase::setEntry(int symbol, frame_t entry) {
+    if (this->frameBuf[symbol] != entry) {
+        this->frameBuf[symbol] = entry;
+        this->frameDirty = true;
+#if DATAVU_PACKED_FRAME
+        this->packSymbol(symbol);
+#endif
+    }
+}
+
 /**
     Update every symbol value in the frame buffer
 */
-int DataVu::updateFrame(int val) {
+int DataVuBase::updateFrame(int val) {
     
     // Check for input errors
-    if (val < 0 || val > 4095) {
+    if (val < 0 || val > DATAVU_VALUE_MAX) {
         return 1;
     }
     
     // Update whole frame buffer
+    frame_t entry = toFrame(val);
     for (int i = 0; i < SYMBOL_COUNT; i++) {
-        this->frameBuf[i] = val;
+        this->setEntry(i, entry);
     }
     
     // Completed successfully
@@ -117,10 +574,10 @@ int DataVu::updateFrame(int val) {
 /**
     Update specific sysmbol in the frame buffer
 */
-int DataVu::updateSymbol(int symbol, int val) {
+int DataVuBase::updateSymbol(int symbol, int val) {
     
     // Check for input errors
-    if (val < 0 || val > 4095) {
+    if (val < 0 || val > DATAVU_VALUE_MAX) {
         return 1;
     }
     else if (symbol < 0 || symbol >= SYMBOL_COUNT) {
@@ -128,218 +585,1275 @@ int DataVu::updateSymbol(int symbol, int val) {
     }
     
     // Update single symbol in frame buffer.
-    this->frameBuf[symbol] = val;
+    this->setEntry(symbol, toFrame(val));
     
     // Completed successfully
     return 0;
 }
 
 /**
-    Write current frame buffer to display
+    Get a symbol value from the frame buffer
 */
-void DataVu::writeFrame() {
-    this->write2Chips(UPDATE_PWM_CMD, this->frameBuf);
+int DataVuBase::getSymbol(int symbol) {
+    
+    // Check for input errors
+    if (symbol < 0 || symbol >= SYMBOL_COUNT) {
+        return -1;
+    }
+    return fromFrame(this->frameBuf[symbol]);
 }
 
 /**
-    Set the state of the calibration feature
+    Load every symbol value in the frame buffer from an array in RAM
 */
-void DataVu::setCal(bool state) {
-
-    if (state) {
-        
-        // Turn calibration feature ON
-        if (not this->calState) {
-            this->write2Chips(TOGGLE_CORRECTION_CMD, this->frameBuf);
-            this->calState = state;
+int DataVuBase::loadFrame(const uint16_t *vals) {
+    
+    // Check for input errors before anything is changed
+    for (int i = 0; i < SYMBOL_COUNT; i++) {
+        if (vals[i] > DATAVU_VALUE_MAX) {
+            return 1;
         }
     }
-    else {
-        
-        // Turn calibration feature OFF
-        if (this->calState) {
-            this->write2Chips(TOGGLE_CORRECTION_CMD, this->frameBuf);
-            this->calState = state;
-        }
+    
+    // Copy frame
+    for (int i = 0; i < SYMBOL_COUNT; i++) {
+        this->setEntry(i, toFrame(vals[i]));
     }
+    
+    // Completed successfully
+    return 0;
 }
 
 /**
-    Update calibration data with a save to EEPROM option
+    Load every symbol value in the frame buffer from an array in flash (PROGMEM)
 */
-int DataVu::writeCal(int cal[SYMBOL_COUNT], bool save) {
+int DataVuBase::loadFrame_P(const uint16_t *vals) {
     
-    // Check for input errors
-    for (int i = 0; i++; i < SYMBOL_COUNT) {
-        if (cal[i] < 0 || cal[i] > 63) {
+    // Check for input errors before anything is changed
+    for (int i = 0; i < SYMBOL_COUNT; i++) {
+        if (pgm_read_word(&vals[i]) > DATAVU_VALUE_MAX) {
             return 1;
         }
     }
     
-    // Save latest calibration data to EEPROM
-    if (save) {
-        EEPROM.put(CALIBRATION_ADDR, cal);
-    }
-    
-    // Reformat 6 bit values to 12 bit values
-    int calTemp[SYMBOL_COUNT];
+    // Copy frame
     for (int i = 0; i < SYMBOL_COUNT; i++) {
-        calTemp[i] = cal[i] << 6;
+        this->setEntry(i, toFrame(pgm_read_word(&vals[i])));
     }
     
-    // Write calibration values to PWM chips
-    this->write2Chips(UPDATE_CORRECTION_CMD, calTemp);
-    
     // Completed successfully
     return 0;
 }
 
 /**
-    Reset PWM chips to default settings
+    Update a range of symbols, first to last inclusive, in the frame buffer
 */
-void DataVu::resetChips() {
+int DataVuBase::fillRange(int first, int last, int val) {
     
-    // Long reset pulse
-    SET_LATCH(HIGH);
-    delay(100);
-    SET_LATCH(LOW);
-    
-    // Turn off correction feature which is enabled by default
-    this->write2Chips(TOGGLE_CORRECTION_CMD, this->frameBuf);
-    this->calState = false;
+    // Check for input errors
+    if (val < 0 || val > DATAVU_VALUE_MAX) {
+        return 1;
+    }
+    else if (first < 0 || last >= SYMBOL_COUNT || first > last) {
+        return 2;
+    }
     
-    // Turn on phase shift feature
-    this->write2Chips(TOGGLE_PHASE_SHIFT_CMD, this->frameBuf);
+    // Update range
+    frame_t entry = toFrame(val);
+    for (int i = first; i <= last; i++) {
+        this->setEntry(i, entry);
+    }
     
-    // Enable PWM output
-    this->write2Chips(ENABLE_PWM_CMD, this->frameBuf);
+    // Completed successfully
+    return 0;
 }
 
 /**
-    Update seven segment display symbols in the frame buffer
+    Update the symbols set in a mask of SYMBOL_MASK_SIZE bytes in the frame buffer
 */
-int DataVu::updateDigit(char c, int digit, int val) {
+int DataVuBase::updateMasked(const uint8_t *mask, int val) {
     
-#if DIGIT_COUNT > 0
-
     // Check for input errors
-    if (val < 0 || val > 4095) {
+    if (val < 0 || val > DATAVU_VALUE_MAX) {
         return 1;
     }
-    else if (digit < 0 || digit >= DIGIT_COUNT) {
-        return 2;
-    }
     
-    // Update frame buffer with
-    const uint8_t bitmap = pgm_read_byte(&CHARACTERARRAY[c]);
-    for (int i = 0; i < 7; i++) {
-        if (bitmap & (1<<i)) {
-            this->frameBuf[SEVSEG_MAP[digit][6-i]] = val;
-        }
-        else {
-            this->frameBuf[SEVSEG_MAP[digit][6-i]] = 0;
+    // Update masked symbols, skipping empty bytes of the mask. Bits past the last symbol are ignored.
+    frame_t entry = toFrame(val);
+    for (int i = 0; i < SYMBOL_MASK_SIZE; i++) {
+        uint8_t bits = mask[i];
+        for (int symbol = i * 8; bits && symbol < SYMBOL_COUNT; symbol++, bits >>= 1) {
+            if (bits & 1) {
+                this->setEntry(symbol, entry);
+            }
         }
     }
     
     // Completed successfully
     return 0;
+}
+
+/**
+    Write current frame buffer to display
+*/
+void DataVuBase::writeFrame(bool force) {
+    if (this->claimFrame(force)) {
+        this->sendFrame();
+    }
+}
+
+/**
+    Check if the frame buffer has changed since it was last written and count skipped writes
+*/
+bool DataVuBase::claimFrame(bool force) {
+    if (not this->frameDirty and not force) {
+        this->skippedWrites++;
+        return false;
+    }
+    this->frameDirty = false;
+    return true;
+}
 
+/**
+    Send frame buffer to PWM chips
+*/
+void DataVuBase::sendFrame() {
+#if DATAVU_PACKED_FRAME
+    this->writePacked(this->frameBits, PACKED_FRAME_SIZE);
 #else
-    // No seven segment display
-    return 3;
+    this->writeChips(UPDATE_PWM_CMD, this->frameBuf);
 #endif
 }
 
 /**
-    Write frame to PWM chips 
+    Number of writes skipped because the frame buffer had not changed
 */
-void DataVu::write2Chips(int cmd, int frame[SYMBOL_COUNT]) {
-    
-    // Define local data variable. This is the actual data which is sent to PWM chips.
-    int data;
-    
-    // Define serial counter - MSB first. 
-    int i = PWM_CHANNEL_COUNT - 1;
+unsigned long DataVuBase::getSkippedWrites() {
+    return this->skippedWrites;
+}
+
+// Resolution of micros(), one Timer0 count
+#define MICROS_STEP_US (64 * 1000000UL / F_CPU)
+
+/**
+    Sets the PCLK frequency, the closest Timer2 can make. Returns the frequency set in Hz, 0 if
+    hz is outside PCLK_MIN_HZ to PCLK_MAX_HZ.
+*/
+unsigned long DataVuBase::setPwmClock(unsigned long hz) {
+    if (hz < PCLK_MIN_HZ || hz > PCLK_MAX_HZ) {
+        return 0;
+    }
     
-    // Write PWM values for chip 2
-    while (i > 47) {
+    // Closest divisor at each prescaler. The smallest prescaler wins a tie, it leaves the
+    // most OCR2A steps for dithering.
+    uint8_t bestCs = 0;
+    unsigned long bestDiv = 0;
+    unsigned long bestErr = 0;
+    for (uint8_t cs = 1; cs < 8; cs++) {
+        unsigned long clock = F_CPU / pgm_read_word(&TIMER2_PRESCALE[cs]);
+        for (unsigned long div = clock / hz; div <= clock / hz + 1; div++) {
+            if (div < 2 || div > 256) {
+                continue;
+            }
+            unsigned long achieved = clock / div;
+            unsigned long err = achieved > hz ? achieved - hz : hz - achieved;
+            if (bestCs == 0 || err < bestErr) {
+                bestCs = cs;
+                bestDiv = div;
+                bestErr = err;
+            }
+        }
+    }
+    
+#if DATAVU_LATCH_SYNC
+    bool running = pclkCycles() != 0;
+#endif
+    startPclk(bestCs, bestDiv - 1);
+#if DATAVU_LATCH_SYNC
+    // Whether the restart adds a PCLK edge depends on where OC2B was in its cycle, so the
+    // chips' count in the PWM period is lost. Reset them to start a period in step with
+    // micros() again.
+    if (running) {
+        this->resync();
+    }
+#endif
+    return this->getPwmClock();
+}
+
+/**
+    PCLK frequency in Hz, 0 when Timer2 is stopped. The centre frequency while dithering.
+*/
+unsigned long DataVuBase::getPwmClock() {
+    uint32_t cycles = pclkCycles();
+    return cycles ? F_CPU / cycles : 0;
+}
+
+/**
+    Sets the rate at which the LT8500s repeat their PWM period, PWM_PERIOD_CLOCKS cycles of
+    PCLK. Returns the rate set in Hz, 0 if it is out of range.
+*/
+float DataVuBase::setRefreshRate(float hz) {
+    if (hz * PWM_PERIOD_CLOCKS < PCLK_MIN_HZ || hz * PWM_PERIOD_CLOCKS > PCLK_MAX_HZ) {
+        return 0;
+    }
+    unsigned long pclk = this->setPwmClock(hz * PWM_PERIOD_CLOCKS + 0.5f);
+    return (float)pclk / PWM_PERIOD_CLOCKS;
+}
+
+/**
+    Period of the LT8500 PWM in microseconds, PWM_PERIOD_CLOCKS cycles of PCLK. 0 when Timer2
+    is stopped. The centre period while dithering.
+*/
+unsigned long DataVuBase::getPwmPeriod() {
+    return PWM_PERIOD_CLOCKS * pclkCycles() / (F_CPU / 1000000);
+}
+
+#if DATAVU_PWM_DITHER
+
+/**
+    Sweeps PCLK over +/- depth steps of OCR2A around the setPwmClock frequency, to spread its
+    emissions. 0 stops the sweep. Returns 1 if the sweep does not fit in OCR2A.
+*/
+int DataVuBase::setPwmDither(uint8_t depth) {
+    if (depth && (depth >= pclkTop || pclkTop + depth > 255)) {
+        return 1;
+    }
+    uint8_t sreg = SREG;
+    cli();
+    ditherDepth = depth;
+    ditherOffset = 0;
+    OCR2A = pclkTop;
+    OCR2B = pclkTop >> 1;
+    if (depth) {
+        TIMSK1 |= (1 << TOIE1);
+    }
+    else {
+        releaseTimer1();
+    }
+    SREG = sreg;
+    return 0;
+}
+
+#endif
+
+// Longest delayMicroseconds() keeps to, its count is an unsigned int
+#define DELAY_US_MAX 16383
+
+/**
+    Latch a PWM frame. With DATAVU_LATCH_SYNC a latch in the last DATAVU_LATCH_GUARD_US, plus
+    32 PCLK cycles, of a PWM period waits for the next period, and the boundary the frame is
+    shown at is recorded. At a slow PCLK the wait can be long, half a second at PCLK_MIN_HZ.
+*/
+void DataVuBase::latchFrame() {
+    uint32_t wait;
+    while ((wait = this->latchWhenClear()) != 0) {
+        delayMicroseconds(wait < DELAY_US_MAX ? wait : DELAY_US_MAX);
+    }
+}
+
+/**
+    Latch a PWM frame unless DATAVU_LATCH_SYNC holds it back for the next PWM period. Returns
+    the microseconds to wait before trying again, 0 once latched.
+*/
+uint32_t DataVuBase::latchWhenClear() {
+#if DATAVU_LATCH_SYNC
+    unsigned long period = this->getPwmPeriod();
+    if (period) {
         
-        // Map the PWM channel to symbol  number
-        if (SYMBOL_MAP[i] < 0) {
-            data = 0;
+        // Time left in the current period. micros() counts in steps of MICROS_STEP_US so the
+        // boundary may be up to a step later than it shows.
+        uint32_t now;
+        uint32_t left = this->pwmPeriodLeft(period, now);
+        if (left <= DATAVU_LATCH_GUARD_US + period / (PWM_PERIOD_CLOCKS / 32)) {
+            return left + MICROS_STEP_US;
+        }
+        else if (left > period - MICROS_STEP_US) {
+            // The boundary micros() shows as just passed may still be to come
+            return MICROS_STEP_US;
+        }
+        this->pins.latch();
+        this->presentedUs = now + left;
+        return 0;
+    }
+#endif
+    this->pins.latch();
+    return 0;
+}
+
+#if DATAVU_LATCH_SYNC
+
+// millis() between wraps of micros(), 2^32us
+#define MICROS_WRAP_MS 4294967UL
+
+/**
+    Microseconds left in the PWM period in progress at micros() time now, period long. Moves
+    pwmEpoch up to the start of that period, so it stays within a period of now and the
+    arithmetic holds as micros() wraps. Latches more than a wrap, about 71 minutes, apart
+    count the wraps from millis(), each one 2^32 % period further into the period.
+*/
+uint32_t DataVuBase::pwmPeriodLeft(uint32_t period, uint32_t &now) {
+    uint8_t sreg = SREG;
+    cli();
+    now = micros();
+    uint32_t nowMs = millis();
+    SREG = sreg;
+    
+    uint32_t elapsed = now - this->pwmEpoch;
+    uint32_t phase = elapsed % period;
+    uint32_t elapsedMs = nowMs - this->pwmEpochMs;
+    if (elapsedMs >= MICROS_WRAP_MS - 1000) {
+        uint32_t wraps = ((uint64_t)elapsedMs * 1000 + (1UL << 31) - elapsed) >> 32;
+        phase = (phase + (uint64_t)wraps * ((uint32_t)0 - period)) % period;
+    }
+    this->pwmEpoch = now - phase;
+    this->pwmEpochMs = nowMs - phase / 1000;
+    return period - phase;
+}
+
+/**
+    Time in micros() at which the last frame latched is shown, the end of the PWM period it
+    was latched in
+*/
+unsigned long DataVuBase::framePresented() {
+    uint8_t sreg = SREG;
+    cli();
+    unsigned long presented = this->presentedUs;
+    SREG = sreg;
+    return presented;
+}
+
+#endif
+
+/**
+    Number of shifts that did not read back intact with DATAVU_VERIFY, retries included
+*/
+unsigned long DataVuBase::getVerifyErrors() {
+    return this->verifyErrors;
+}
+
+/**
+    Hand the current frame buffer to the transmission engine and return
+*/
+void DataVuBase::writeFrameAsync(bool force) {
+    
+    // Skip if the display already shows the frame buffer
+    if (not this->claimFrame(force)) {
+        return;
+    }
+    
+#if DATAVU_ASYNC
+    
+    // Called while the back buffer is being written, e.g. from an ISR. Ask the owner to refill it.
+    uint8_t sreg = SREG;
+    cli();
+    if (txFilling) {
+        if (txChain[txFront ^ 1] == this) {
+            txRefill = true;
         }
         else {
-            data = frame[SYMBOL_MAP[i]];
+            this->frameDirty = true;
+        }
+        SREG = sreg;
+        return;
+    }
+    
+    // The back buffer holds another chain's frame. Wait for the engine to take it, or leave the
+    // frame dirty if interrupts are off and the engine cannot run.
+    while (txPending && txChain[txFront ^ 1] != this) {
+        if (not (sreg & (1 << SREG_I))) {
+            this->frameDirty = true;
+            SREG = sreg;
+            return;
+        }
+        SREG = sreg;
+        cli();
+    }
+    
+    // Take the back buffer off the queue while it is written
+    txFilling = true;
+    txPending = false;
+    uint8_t *back = txBuf[txFront ^ 1];
+    txChain[txFront ^ 1] = this;
+    txShift[txFront ^ 1] = this->pins.shiftBytes;
+    SREG = sreg;
+    
+    do {
+        txRefill = false;
+        this->frameDirty = false;
+#if DATAVU_PACKED_FRAME
+        memcpy(back, this->frameBits, PACKED_FRAME_SIZE);
+#else
+        this->packFrame(back, UPDATE_PWM_CMD, this->frameBuf);
+#endif
+    } while (txRefill);
+    
+    // Queue back buffer and start the engine if idle
+    sreg = SREG;
+    cli();
+    txFilling = false;
+    txPending = true;
+    if (not txBusy) {
+        txBusy = true;
+        txNext();
+    }
+    SREG = sreg;
+    
+#else
+    
+    // No transmission engine - write now, unless this interrupted a blocking write. The frame
+    // is then sent when that write releases the bus.
+    uint8_t sreg = SREG;
+    cli();
+    if (busBusy) {
+        this->frameDirty = true;
+        if (busDeferred == NULL) {
+            busDeferred = this;
+        }
+        SREG = sreg;
+        return;
+    }
+    SREG = sreg;
+    this->sendFrame();
+    if (txCallback) {
+        txCallback();
+    }
+    
+#endif
+}
+
+/**
+    Check if the transmission engine is still sending a frame
+*/
+bool DataVuBase::isBusy() {
+#if DATAVU_ASYNC
+    return txBusy || txPending;
+#else
+    return false;
+#endif
+}
+
+/**
+    Set a function to be called once each asynchronous frame is latched
+*/
+void DataVuBase::onFrameSent(void (*callback)(void)) {
+    txCallback = callback;
+}
+
+/**
+    Set the master brightness. Scales every channel as the frame is shifted out.
+*/
+void DataVuBase::setMasterBrightness(uint8_t brightness) {
+    if (this->brightness == brightness) {
+        return;
+    }
+    this->brightness = brightness;
+    this->frameDirty = true;
+    
+#if DATAVU_PACKED_FRAME
+    // Packed frame holds scaled values
+    for (int i = 0; i < SYMBOL_COUNT; i++) {
+        this->packSymbol(i);
+    }
+#endif
+}
+
+/**
+    Get the master brightness
+*/
+uint8_t DataVuBase::getMasterBrightness() {
+    return this->brightness;
+}
+
+/**
+    Set the state of the calibration feature
+*/
+void DataVuBase::setCal(bool state) {
+    this->setConfig(state ? this->wantConfig | CHIP_CORRECTION : this->wantConfig & ~CHIP_CORRECTION);
+}
+
+/**
+    Set the state of the phase shift feature
+*/
+void DataVuBase::setPhaseShift(bool state) {
+    this->setConfig(state ? this->wantConfig | CHIP_PHASE_SHIFT : this->wantConfig & ~CHIP_PHASE_SHIFT);
+}
+
+/**
+    Enable or disable the PWM outputs
+*/
+void DataVuBase::setOutputs(bool state) {
+    this->setConfig(state ? this->wantConfig | CHIP_OUTPUTS : this->wantConfig & ~CHIP_OUTPUTS);
+}
+
+/**
+    Set the configuration of the chips. Commands are only sent for the features that differ
+    from the shadow of the chips' configuration.
+*/
+int DataVuBase::setConfig(uint8_t config) {
+    this->wantConfig = config & CHIP_CONFIG_MASK;
+    return this->applyConfig(this->wantConfig) ? 0 : 1;
+}
+
+/**
+    Get the configuration the chips are in, as far as the library knows
+*/
+uint8_t DataVuBase::getConfig() {
+    return this->chipConfig;
+}
+
+/**
+    Send the commands that take the chips from the shadow configuration to config, updating
+    the shadow as each is latched. Returns false if a command was dropped by DATAVU_VERIFY.
+*/
+bool DataVuBase::applyConfig(uint8_t config) {
+    uint8_t diff = config ^ this->chipConfig;
+    
+    // Correction takes effect when the PWM values are written again
+    if (diff & CHIP_CORRECTION) {
+        if (this->writeCommand(TOGGLE_CORRECTION_CMD)) {
+            this->chipConfig ^= CHIP_CORRECTION;
+        }
+        this->frameDirty = true;
+    }
+    if (diff & CHIP_PHASE_SHIFT) {
+        if (this->writeCommand(TOGGLE_PHASE_SHIFT_CMD)) {
+            this->chipConfig ^= CHIP_PHASE_SHIFT;
+        }
+    }
+    if (diff & CHIP_OUTPUTS) {
+        if (this->writeCommand(config & CHIP_OUTPUTS ? ENABLE_PWM_CMD : DISABLE_PWM_CMD)) {
+            this->chipConfig ^= CHIP_OUTPUTS;
+        }
+    }
+    return this->chipConfig == config;
+}
+
+/**
+    Save calibration data to a profile in EEPROM
+*/
+int DataVuBase::saveCal(int cal[SYMBOL_COUNT], uint8_t profile, const char *name) {
+    
+    // Check for input errors
+    for (int i = 0; i < SYMBOL_COUNT; i++) {
+        if (cal[i] < 0 || cal[i] > 63) {
+            return 1;
+        }
+    }
+    if (profile >= CAL_PROFILE_COUNT) {
+        return 2;
+    }
+    
+    // Write the slot after the newest, so the newest is kept until this one is complete
+    int8_t newest = newestCal(profile, 0);
+    uint8_t slot = newest < 0 ? 0 : (newest + 1) % CAL_SLOT_COUNT;
+    uint8_t seq = newest < 0 ? 0 : EEPROM.read(calAddr(profile, newest) + 3) + 1;
+    int addr = calAddr(profile, slot);
+    int start = addr;
+    
+    // Keep the name of the newest record when none is given
+    char oldName[CAL_NAME_SIZE + 1] = "";
+    if (name == NULL) {
+        if (newest >= 0) {
+            readCalRecord(calAddr(profile, newest), NULL, oldName);
+        }
+        name = oldName;
+    }
+    
+    // Header. The magic is written last so a record cut short is never found.
+    EEPROM.update(addr++, 0xFF);
+    uint16_t crc = _crc_ccitt_update(0xFFFF, CAL_MAGIC);
+    crc = writeCalByte(addr, CAL_VERSION, crc);
+    crc = writeCalByte(addr, CAL_TAG, crc);
+    crc = writeCalByte(addr, seq, crc);
+    
+    // Name, padded with zeros
+    bool end = false;
+    for (uint8_t i = 0; i < CAL_NAME_SIZE; i++) {
+        end = end || name[i] == '\0';
+        crc = writeCalByte(addr, end ? 0 : name[i], crc);
+    }
+    
+    // Six bit values, four to three bytes
+    uint8_t packed[CAL_DATA_SIZE];
+    packCal(cal, packed);
+    for (int i = 0; i < CAL_DATA_SIZE; i++) {
+        crc = writeCalByte(addr, packed[i], crc);
+    }
+    
+    // CRC, then the magic
+    EEPROM.update(addr, crc & 0xFF);
+    EEPROM.update(addr + 1, crc >> 8);
+    EEPROM.update(start, CAL_MAGIC);
+    
+    // Completed successfully
+    return 0;
+}
+
+/**
+    Read calibration data and its name from a profile in EEPROM
+*/
+int DataVuBase::readCal(int cal[SYMBOL_COUNT], uint8_t profile, char *name) {
+    
+    // Check for input errors
+    if (profile >= CAL_PROFILE_COUNT) {
+        return 1;
+    }
+    
+    // Newest record with a good CRC, older records are used if a newer one is corrupt
+    uint8_t tried = 0;
+    int8_t slot;
+    while ((slot = newestCal(profile, tried)) >= 0) {
+        if (readCalRecord(calAddr(profile, slot), cal, name)) {
+            return 0;
+        }
+        tried |= 1 << slot;
+    }
+    
+    // No valid record
+    return 2;
+}
+
+/**
+    Load a calibration profile from EEPROM into the PWM chips
+*/
+int DataVuBase::loadCal(uint8_t profile) {
+    int cal[SYMBOL_COUNT];
+    int result = this->readCal(cal, profile);
+    if (result) {
+        return result;
+    }
+    this->calProfile = profile;
+    return this->writeCal(cal);
+}
+
+/**
+    Find a calibration profile by name, -1 if none has it
+*/
+int DataVuBase::findCal(const char *name) {
+    char found[CAL_NAME_SIZE + 1];
+    for (uint8_t profile = 0; profile < CAL_PROFILE_COUNT; profile++) {
+        if (this->readCal(NULL, profile, found) == 0 && strncmp(name, found, CAL_NAME_SIZE) == 0) {
+            return profile;
+        }
+    }
+    return -1;
+}
+
+/**
+    Get the calibration profile last loaded, which writeCal saves to
+*/
+uint8_t DataVuBase::getCalProfile() {
+    return this->calProfile;
+}
+
+/**
+    Update calibration data with a save to EEPROM option
+*/
+int DataVuBase::writeCal(int cal[SYMBOL_COUNT], bool save) {
+    
+    // Check for input errors
+    for (int i = 0; i < SYMBOL_COUNT; i++) {
+        if (cal[i] < 0 || cal[i] > 63) {
+            return 1;
+        }
+    }
+    
+    // Save latest calibration data to the current profile in EEPROM
+    if (save) {
+        this->saveCal(cal, this->calProfile);
+    }
+    
+    // Nothing to send if the correction registers already hold these values
+    uint8_t packed[CAL_DATA_SIZE];
+    packCal(cal, packed);
+    if (this->calLoaded && memcmp(packed, this->calShadow, CAL_DATA_SIZE) == 0) {
+        return 0;
+    }
+    memcpy(this->calShadow, packed, CAL_DATA_SIZE);
+    this->calSet = true;
+    this->sendCal();
+    
+    // Completed successfully
+    return 0;
+}
+
+/**
+    Write the shadow correction values to the PWM chips
+*/
+void DataVuBase::sendCal() {
+    
+    // Reformat 6 bit values to the top of frame buffer entries, shifted out as 12 bit values
+    frame_t calTemp[SYMBOL_COUNT];
+    for (int i = 0; i < SYMBOL_COUNT; i++) {
+        calTemp[i] = unpackCal(this->calShadow, i) << (6 - DATAVU_FRAME_SHIFT);
+    }
+    
+    // Write calibration values to PWM chips. PWM values need writing again to take effect.
+    this->calLoaded = this->writeChips(UPDATE_CORRECTION_CMD, calTemp);
+    this->frameDirty = true;
+}
+
+/**
+    Reset PWM chips to default settings
+*/
+void DataVuBase::resetChips() {
+    this->wantConfig = CHIP_DEFAULT_CONFIG;
+    this->calSet = false;
+    this->resync();
+}
+
+/**
+    Reset the PWM chips and restore the configuration, correction values and frame buffer the
+    library holds. Recovers chips that missed or misread a command.
+*/
+void DataVuBase::resync() {
+    
+    // Reset pulse, once any frame being shifted is done
+    acquireBus();
+    this->pins.setLatch(HIGH);
+#if DATAVU_FAST_BOOT
+    delayMicroseconds(LT8500_RESET_US);
+#else
+    delay(100);
+#endif
+    this->pins.setLatch(LOW);
+    releaseBus();
+#if DATAVU_LATCH_SYNC
+    this->pwmEpoch = micros();
+    this->pwmEpochMs = millis();
+    this->presentedUs = this->pwmEpoch;
+#endif
+    this->chipConfig = CHIP_RESET_CONFIG;
+    this->calLoaded = false;
+    
+    // Correction values and features, then the PWM values cleared by the reset, before the
+    // outputs are enabled. These cannot be merged: an LT8500 frame carries one command code,
+    // acted on at its latch, and each feature is switched by its own toggle command.
+    if (this->calSet) {
+        this->sendCal();
+    }
+    this->applyConfig(this->wantConfig & ~CHIP_OUTPUTS);
+    this->frameDirty = false;
+    this->sendFrame();
+    this->applyConfig(this->wantConfig);
+}
+
+/**
+    Save the frame buffer and LED voltage as the splash frame shown by begin
+*/
+void DataVuBase::saveSplash(void) {
+    
+    int addr = SPLASH_ADDR;
+    
+    // Header. The magic is written last so a save cut short is never shown.
+    EEPROM.update(addr++, 0xFF);
+    uint16_t crc = _crc_ccitt_update(0xFFFF, SPLASH_MAGIC);
+    crc = writeCalByte(addr, CAL_TAG, crc);
+    crc = writeCalByte(addr, OCR1A, crc);
+    
+    // Eight bit values, as the firmware commands
+    for (int i = 0; i < SYMBOL_COUNT; i++) {
+        crc = writeCalByte(addr, fromFrame(this->frameBuf[i]) / DATAVU_VALUE_SCALE, crc);
+    }
+    
+    // CRC, then the magic
+    EEPROM.update(addr, crc & 0xFF);
+    EEPROM.update(addr + 1, crc >> 8);
+    EEPROM.update(SPLASH_ADDR, SPLASH_MAGIC);
+}
+
+/**
+    Remove the splash frame so begin starts with a dark display
+*/
+void DataVuBase::clearSplash(void) {
+    EEPROM.update(SPLASH_ADDR, 0xFF);
+}
+
+/**
+    Load the splash frame into the frame buffer and set its voltage. Returns false if there is
+    no valid splash frame, the frame buffer is then undefined.
+*/
+bool DataVuBase::readSplash(void) {
+    
+    int addr = SPLASH_ADDR;
+    if (EEPROM.read(addr) != SPLASH_MAGIC || EEPROM.read(addr + 1) != CAL_TAG) {
+        return false;
+    }
+    
+    // Header, values straight into the frame buffer
+    uint16_t crc = 0xFFFF;
+    for (uint8_t i = 0; i < 3; i++) {
+        crc = _crc_ccitt_update(crc, EEPROM.read(addr++));
+    }
+    for (int i = 0; i < SYMBOL_COUNT; i++) {
+        uint8_t value = EEPROM.read(addr++);
+        crc = _crc_ccitt_update(crc, value);
+        this->setEntry(i, toFrame(value * DATAVU_VALUE_SCALE));
+    }
+    if (EEPROM.read(addr) != (crc & 0xFF) || EEPROM.read(addr + 1) != (crc >> 8)) {
+        return false;
+    }
+    
+    // Voltage
+    OCR1A = EEPROM.read(SPLASH_ADDR + 2);
+    return true;
+}
+
+/**
+    Latch a command that does not use the channel data in every chip. Returns false if it did
+    not read back intact with DATAVU_VERIFY and was dropped.
+*/
+bool DataVuBase::writeCommand(int cmd) {
+#if DATAVU_VERIFY
+    return this->checkChips(cmd, NULL, NULL);
+#else
+    
+    // Wait for any asynchronous frame to finish
+    acquireBus();
+    
+    // The channel bits are ignored so nothing needs serializing
+    uint8_t bits[CHIP_FRAME_SIZE] = {0};
+    bits[CHIP_FRAME_SIZE - 1] = cmd;
+    for (uint8_t chip = 0; chip < LT8500_COUNT; chip++) {
+        this->pins.shiftBytes(bits, CHIP_FRAME_SIZE);
+    }
+    
+    // Latch data
+    this->pins.latch();
+    
+    releaseBus();
+    return true;
+#endif
+}
+
+/**
+    Run the LT8500 self test and read back the status frames. Symbols with an open LED are set
+    in openLeds, a SYMBOL_MASK_SIZE byte mask as taken by updateMasked, unless it is NULL.
+*/
+int DataVuBase::diagnostics(uint8_t *openLeds) {
+    
+    if (openLeds) {
+        memset(openLeds, 0, SYMBOL_MASK_SIZE);
+    }
+    if (not this->pins.hasSdo) {
+        return DIAG_NO_SDO;
+    }
+    
+    // The self test leaves its results in the status frames
+    this->writeCommand(SELF_TEST_CMD);
+    
+    // Shift the status frames out, the last chip first. The empty frames shifted in are
+    // replaced by the next write before anything is latched.
+    acquireBus();
+    int result = 0;
+    uint8_t empty[CHIP_FRAME_SIZE] = {0};
+    uint8_t status[CHIP_FRAME_SIZE];
+    for (uint8_t chip = LT8500_COUNT; chip-- > 0;) {
+        this->pins.shiftRead(empty, status, CHIP_FRAME_SIZE);
+        if (status[CHIP_FRAME_SIZE - 1] & LT8500_STATUS_OT) {
+            result |= DIAG_OVER_TEMP;
         }
         
-        // Write data to PWM chip 2
-        for (int j = 11; j >= 0; j--) {
-            
-            if (1 << j & data) {
-                SET_SDI(HIGH);
+        // Open LED flag in the MSB of each twelve bit field, channel 47 first
+        channel_t i = (chip + 1) * CHIP_CHANNEL_COUNT - 1;
+        for (uint16_t bit = 0; bit < CHIP_CHANNEL_COUNT * 12; bit += 12) {
+            int16_t symbol = readSymbol(&SYMBOL_MAP[i--]);
+            if (symbol >= 0 && (status[bit >> 3] & (0x80 >> (bit & 7)))) {
+                result |= DIAG_OPEN_LED;
+                if (openLeds) {
+                    openLeds[symbol >> 3] |= 1 << (symbol & 7);
+                }
             }
-            else {
-                SET_SDI(LOW);
-            }
-            SET_SCKI(HIGH);
-            SET_SCKI(LOW);
         }
-        i--;
+    }
+    releaseBus();
+    
+    return result;
+}
+
+/**
+    Update seven segment display symbols in the frame buffer
+*/
+int DataVuBase::updateDigit(char c, int digit, int val) {
+    
+#if DIGIT_COUNT > 0
+
+    // Check for input errors
+    if (val < 0 || val > DATAVU_VALUE_MAX) {
+        return 1;
+    }
+    else if (digit < 0 || digit >= DIGIT_COUNT) {
+        return 2;
     }
     
-    // Write command for chip 2
-    for (int i = 7; i >= 0; i--){
-        if (1 << i & cmd) {
-            SET_SDI(HIGH);
+    // Update frame buffer with
+    const uint8_t bitmap = pgm_read_byte(&CHARACTERARRAY[c]);
+    for (int i = 0; i < 7; i++) {
+        int16_t symbol = readSymbol(&SEVSEG_MAP[digit][6-i]);
+        this->setEntry(symbol, (bitmap & (1<<i)) ? toFrame(val) : 0);
+    }
+    
+    // Completed successfully
+    return 0;
+
+#else
+    // No seven segment display
+    return 3;
+#endif
+}
+
+#if DIGIT_COUNT > 0
+
+/**
+    Justify the characters of a number on the digits. chars holds count digits, least significant
+    first, and gets the sign and blanks. Returns the digit the least significant digit moved to.
+*/
+static uint8_t placeDigits(uint8_t *chars, uint8_t count, bool negative, uint8_t justify) {
+    
+    if (justify == NUMBER_ZEROS) {
+        count = DIGIT_COUNT - negative;
+    }
+    uint8_t shift = justify == NUMBER_LEFT ? DIGIT_COUNT - count - negative : 0;
+    
+    // Move digits up from the top so nothing is overwritten before it is moved
+    for (int8_t d = DIGIT_COUNT - 1; d >= 0; d--) {
+        int8_t src = d - shift;
+        if (src >= 0 && src < count) {
+            chars[d] = chars[src];
         }
         else {
-            SET_SDI(LOW);
+            chars[d] = (negative && src == count) ? '-' : ' ';
         }
-        SET_SCKI(HIGH);
-        SET_SCKI(LOW);
     }
+    return shift;
+}
+
+#endif
+
+/**
+    Show a signed decimal number on the seven segment digits
+*/
+int DataVuBase::displayNumber(int32_t number, uint8_t decimals, uint8_t justify, int val) {
     
-    // Write PWM values for chip 1
-    while (i >= 0) {
-        
-        // Map the PWM channel to symbol number
-        if (SYMBOL_MAP[i] < 0) {
-            data = 0;
+#if DIGIT_COUNT > 0
+
+    // Check for input errors
+    if (val < 0 || val > DATAVU_VALUE_MAX || decimals >= DIGIT_COUNT) {
+        return 1;
+    }
+    
+    bool negative = number < 0;
+    uint32_t n = negative ? 0 - (uint32_t)number : number;
+    uint8_t chars[DIGIT_COUNT];
+    uint8_t count = decimals + 1;
+    
+    // Binary to BCD by subtracting powers of ten, at most nine times a digit. Digits after the
+    // decimal point are kept when zero.
+    if (n < pgm_read_dword(&POWERS_OF_TEN[DIGIT_COUNT])) {
+        for (int8_t d = DIGIT_COUNT - 1; d >= 0; d--) {
+            uint32_t power = pgm_read_dword(&POWERS_OF_TEN[d]);
+            uint8_t digit = 0;
+            while (n >= power) {
+                n -= power;
+                digit++;
+            }
+            chars[d] = digit;
+            if (digit && count <= d) {
+                count = d + 1;
+            }
         }
-        else {
-            data = frame[SYMBOL_MAP[i]];
+    }
+    else {
+        count = DIGIT_COUNT + 1;
+    }
+    
+    // Number does not fit, show dashes
+    if (count + negative > DIGIT_COUNT) {
+        memset(chars, '-', DIGIT_COUNT);
+        this->showDigits(chars, -1, toFrame(val));
+        return 2;
+    }
+    
+    uint8_t shift = placeDigits(chars, count, negative, justify);
+    this->showDigits(chars, decimals ? decimals + shift : -1, toFrame(val));
+    
+    // Completed successfully
+    return 0;
+
+#else
+    // No seven segment display
+    (void)number;
+    (void)decimals;
+    (void)justify;
+    (void)val;
+    return 3;
+#endif
+}
+
+/**
+    Show an unsigned hexadecimal number on the seven segment digits
+*/
+int DataVuBase::displayHex(uint32_t number, uint8_t justify, int val) {
+    
+#if DIGIT_COUNT > 0
+
+    // Check for input errors
+    if (val < 0 || val > DATAVU_VALUE_MAX) {
+        return 1;
+    }
+    
+    // One nibble per digit, least significant first
+    uint8_t chars[DIGIT_COUNT];
+    uint8_t count = 1;
+    for (uint8_t d = 0; d < DIGIT_COUNT; d++) {
+        chars[d] = number & 0x0F;
+        number >>= 4;
+        if (chars[d]) {
+            count = d + 1;
+        }
+    }
+    
+    // Number does not fit, show dashes
+    if (number) {
+        memset(chars, '-', DIGIT_COUNT);
+        this->showDigits(chars, -1, toFrame(val));
+        return 2;
+    }
+    
+    placeDigits(chars, count, false, justify);
+    this->showDigits(chars, -1, toFrame(val));
+    
+    // Completed successfully
+    return 0;
+
+#else
+    // No seven segment display
+    (void)number;
+    (void)justify;
+    (void)val;
+    return 3;
+#endif
+}
+
+/**
+    Show a character on every digit. chars holds CHARACTERARRAY indexes, digit 0 first. point is
+    the digit whose decimal point is lit, -1 for none.
+*/
+void DataVuBase::showDigits(const uint8_t *chars, int8_t point, frame_t entry) {
+    
+#if DIGIT_COUNT > 0
+#if !SEVSEG_HAS_DP
+    (void)point;
+#endif
+    for (uint8_t d = 0; d < DIGIT_COUNT; d++) {
+        uint8_t bitmap = pgm_read_byte(&CHARACTERARRAY[chars[d]]);
+        for (uint8_t i = 0; i < 7; i++) {
+            this->setEntry(readSymbol(&SEVSEG_MAP[d][6-i]), (bitmap & (1<<i)) ? entry : 0);
+        }
+#if SEVSEG_HAS_DP
+        this->setEntry(readSymbol(&SEVSEG_DP_MAP[d]), d == point ? entry : 0);
+#endif
+    }
+#else
+    (void)chars;
+    (void)point;
+    (void)entry;
+#endif
+}
+
+/**
+    Write frame to PWM chips. Returns false if it was dropped by DATAVU_VERIFY.
+*/
+bool DataVuBase::writeChips(int cmd, frame_t frame[SYMBOL_COUNT]) {
+#if DATAVU_VERIFY
+    return this->checkChips(cmd, frame, NULL);
+#else
+    
+    // Wait for any asynchronous frame to finish
+    acquireBus();
+    
+    // Serialize and shift one chip at a time, the last in the chain first
+    uint8_t bits[CHIP_FRAME_SIZE];
+    for (uint8_t chip = LT8500_COUNT; chip-- > 0;) {
+        this->packChip(bits, cmd, frame, chip);
+        this->pins.shiftBytes(bits, CHIP_FRAME_SIZE);
+    }
+    
+    // Latch data
+    if (cmd == UPDATE_PWM_CMD) {
+        this->latchFrame();
+    }
+    else {
+        this->pins.latch();
+    }
+    
+    releaseBus();
+    return true;
+#endif
+}
+
+#if DATAVU_VERIFY
+
+/**
+    Blocking write with read back. Shifts the frame, then shifts it again while the first pass
+    comes out of SDO and latches if the two match. Each chip's bytes are taken from packed,
+    packed from frame, or are cmd with no channel data when both are NULL. Returns false if
+    the frame was dropped after DATAVU_VERIFY_RETRIES retries.
+*/
+bool DataVuBase::checkChips(int cmd, frame_t *frame, const uint8_t *packed) {
+    
+    // Wait for any asynchronous frame to finish
+    acquireBus();
+    
+    uint8_t bits[CHIP_FRAME_SIZE];
+    if (not frame && not packed) {
+        memset(bits, 0, CHIP_FRAME_SIZE);
+        bits[CHIP_FRAME_SIZE - 1] = cmd;
+    }
+    
+    for (uint8_t retry = 0; retry <= DATAVU_VERIFY_RETRIES; retry++) {
+        uint8_t diff = 0;
+        for (uint8_t pass = 0; pass < 2; pass++) {
+            
+            // Serialize and shift one chip at a time, the last in the chain first
+            for (uint8_t chip = LT8500_COUNT; chip-- > 0;) {
+                const uint8_t *p = bits;
+                if (packed) {
+                    p = packed + (LT8500_COUNT - 1 - chip) * CHIP_FRAME_SIZE;
+                }
+                else if (frame) {
+                    this->packChip(bits, cmd, frame, chip);
+                }
+                
+                if (pass == 0) {
+                    this->pins.shiftBytes(p, CHIP_FRAME_SIZE);
+                }
+                else {
+                    diff |= this->pins.shiftRead(p, NULL, CHIP_FRAME_SIZE);
+                }
+            }
         }
         
-        // Write data to PWM chip 1
-        for (int j = 11; j >= 0; j--) {
-            if (1 << j & data) {
-                SET_SDI(HIGH);
+        // Latch data
+        if (diff == 0) {
+            if (cmd == UPDATE_PWM_CMD) {
+                this->latchFrame();
             }
             else {
-                SET_SDI(LOW);
+                this->pins.latch();
             }
-            SET_SCKI(HIGH);
-            SET_SCKI(LOW);
+            releaseBus();
+            return true;
         }
-        i--;
+        this->verifyErrors++;
     }
     
-    // Write command for chip 1
-    for (int i = 7; i >= 0; i--){
-        if (1 << i & cmd) {
-            SET_SDI(HIGH);
+    // Dropped, the next writeFrame sends the frame buffer again
+    if (cmd == UPDATE_PWM_CMD) {
+        this->frameDirty = true;
+    }
+    releaseBus();
+    return false;
+}
+
+#endif
+
+/**
+    Serialize one chip's channels and command into LT8500 shift order
+*/
+void DataVuBase::packChip(uint8_t *bits, int cmd, frame_t frame[SYMBOL_COUNT], uint8_t chip) {
+    
+    // Correction values only need moving to the top of 12 bits, frame values may need expanding,
+    // the gamma table and brightness
+    uint16_t scale = brightnessScale(this->brightness);
+    bool pwm = cmd != UPDATE_CORRECTION_CMD && (DATAVU_FRAME_SHIFT || scale < 256);
+    
+    // Define serial counter - MSB first
+    channel_t i = (chip + 1) * CHIP_CHANNEL_COUNT - 1;
+    
+    // Two 12 bit values fill three bytes
+    for (uint8_t j = 0; j < CHIP_CHANNEL_COUNT; j += 2) {
+        uint16_t a = channelValue(frame, readSymbol(&SYMBOL_MAP[i--]));
+        uint16_t b = channelValue(frame, readSymbol(&SYMBOL_MAP[i--]));
+        if (pwm) {
+            a = pwmValue(a, scale);
+            b = pwmValue(b, scale);
         }
         else {
-            SET_SDI(LOW);
+            a <<= DATAVU_FRAME_SHIFT;
+            b <<= DATAVU_FRAME_SHIFT;
         }
-        SET_SCKI(HIGH);
-        SET_SCKI(LOW);
+        *bits++ = a >> 4;
+        *bits++ = (a << 4) | (b >> 8);
+        *bits++ = b;
     }
     
-    // Set SDI low
-    SET_SDI(LOW);
+    // Command byte
+    *bits = cmd;
+}
 
+#if DATAVU_ASYNC && !DATAVU_PACKED_FRAME
+
+/**
+    Serialize a frame into LT8500 shift order
+*/
+void DataVuBase::packFrame(uint8_t *bits, int cmd, frame_t frame[SYMBOL_COUNT]) {
+    for (uint8_t chip = LT8500_COUNT; chip-- > 0;) {
+        this->packChip(bits, cmd, frame, chip);
+        bits += CHIP_FRAME_SIZE;
+    }
+}
+
+#endif
+
+#if DATAVU_PACKED_FRAME
+
+/**
+    Copy a symbol from the frame buffer into the packed frame
+*/
+void DataVuBase::packSymbol(int symbol) {
+    
+    // Locate the channel's 12 bits in the shift stream. The last chip in the chain is shifted first.
+    channel_t channel = this->symbolChannel[symbol];
+    if (channel == NO_CHANNEL) {
+        return;
+    }
+    uint8_t chip = channel / CHIP_CHANNEL_COUNT;
+    uint8_t slot = CHIP_CHANNEL_COUNT - 1 - channel % CHIP_CHANNEL_COUNT;
+    uint8_t *p = this->frameBits + (LT8500_COUNT - 1 - chip) * CHIP_FRAME_SIZE + slot * 3 / 2;
+    
+    // Patch value in place. Even slots start on a byte boundary, odd slots mid byte.
+    uint16_t data = pwmValue(this->frameBuf[symbol], brightnessScale(this->brightness));
+    if (slot & 1) {
+        p[0] = (p[0] & 0xF0) | (data >> 8);
+        p[1] = data;
+    }
+    else {
+        p[0] = data >> 4;
+        p[1] = (p[1] & 0x0F) | (data << 4);
+    }
+}
+
+/**
+    Stream a packed frame to PWM chips - MSB first
+*/
+void DataVuBase::writePacked(const uint8_t *bits, int count) {
+#if DATAVU_VERIFY
+    (void)count;
+    this->checkChips(UPDATE_PWM_CMD, NULL, bits);
+#else
+    
+    // Wait for any asynchronous frame to finish
+    acquireBus();
+    
+    // Stream bytes
+    this->pins.shiftBytes(bits, count);
+    
     // Latch data
-    SET_LATCH(HIGH);
-    SET_LATCH(LOW);
+    this->latchFrame();
+    
+    releaseBus();
+#endif
 }
+
+#endif
@@ -18,8 +18,12 @@
     along with this program.  If not, see <https://www.gnu.org/licenses/>.
 ******************************************************************************/
 
+#ifndef DATAVULIB_H
+#define DATAVULIB_H
+
 #include <Arduino.h>
 #include <EEPROM.h>
+#include "dataVuConfig.h"
 
 // Verison number
 #define DATAVULIB_VERSION "1.0"
@@ -41,13 +45,58 @@
 #define SET_SDI(state)      (state ? PORTD |= (1UL << 5) : PORTD &= ~(1UL << 5))
 #define SET_SCKI(state)     (state ? PORTD |= (1UL << 6) : PORTD &= ~(1UL << 6))
 
+// PORTD bit masks of the serial pins
+#define LATCH_BIT   (1 << 7)
+#define SDI_BIT     (1 << 5)
+#define SCKI_BIT    (1 << 6)
+
+/*
+    Port and pins of an LT8500 chain, used as the template argument of DataVuChain. Declares a
+    struct with port() and ddr() giving the port's registers and the bit masks of the SDI, SCKI
+    and LATCH pins:
+
+        DATAVU_PINS(PanelPins, PORTC, DDRC, 0, 1, 2);
+        DataVuChain<PanelPins> panel;
+
+    DATAVU_PINS_SDO also takes the input register and pin of the last chip's SDO, on the same
+    port, for DATAVU_VERIFY and diagnostics():
+
+        DATAVU_PINS_SDO(PanelPins, PORTC, PINC, DDRC, 0, 1, 2, 3);
+*/
+#define DATAVU_PINS_SDO(name, PORTX, PINX, DDRX, sdi, scki, latch, sdo) \
+    struct name {                                               \
+        static auto port() -> decltype((PORTX)) { return PORTX; } \
+        static auto ddr() -> decltype((DDRX)) { return DDRX; }  \
+        static uint8_t pin() { return PINX; }                   \
+        enum {                                                  \
+            SDI = 1 << (sdi),                                   \
+            SCKI = 1 << (scki),                                 \
+            LATCH = 1 << (latch),                               \
+            SDO = (sdo) < 0 ? 0 : 1 << ((sdo) & 7)              \
+        };                                                      \
+    }
+#define DATAVU_PINS(name, PORTX, DDRX, sdi, scki, latch)        \
+    DATAVU_PINS_SDO(name, PORTX, 0, DDRX, sdi, scki, latch, -1)
+
+// Pins of the Data-Vu driver board
+DATAVU_PINS_SDO(DataVuPortD, PORTD, PIND, DDRD, PWM_SDI, PWM_SCKI, PWM_LATCH, PWM_SDO);
+
 // Define LT8500 command codes
 #define UPDATE_PWM_CMD          0x00
 #define ENABLE_PWM_CMD          0x30
 #define DISABLE_PWM_CMD         0x40
 #define TOGGLE_CORRECTION_CMD   0x70
+#define SELF_TEST_CMD           0x50
 #define UPDATE_CORRECTION_CMD   0x20
-#define TOGGLE_PHASE_SHIFT_CMD  0x06
+#define TOGGLE_PHASE_SHIFT_CMD  0x60
+
+// LT8500 configuration, the same in every chip, as CHIP_* flags OR'd together
+#define CHIP_CORRECTION     0x01    // Correction registers scale the PWM values
+#define CHIP_PHASE_SHIFT    0x02    // Channels switch on at staggered times
+#define CHIP_OUTPUTS        0x04    // PWM outputs enabled
+#define CHIP_CONFIG_MASK    0x07
+#define CHIP_RESET_CONFIG   CHIP_CORRECTION                     // After a reset
+#define CHIP_DEFAULT_CONFIG (CHIP_PHASE_SHIFT | CHIP_OUTPUTS)   // Set by begin
 
 // Maximum allowable voltage
 #define MAX_VOLTAGE 5
@@ -55,22 +104,194 @@
 // Define converstion factors
 #define V2DAC 51    // Convert 0-5V to eight bit integer
 
-// Number of PWM channels (2x LT8500 chips)
-#define PWM_CHANNEL_COUNT 96
+// Number of daisy chained LT8500 chips. The Data-Vu driver board has two, larger panels
+// set this with a DATAVU_PROFILE header.
+#ifndef LT8500_COUNT
+#define LT8500_COUNT 2
+#endif
+
+// Number of PWM channels (48 per LT8500 chip)
+#define CHIP_CHANNEL_COUNT 48
+#define PWM_CHANNEL_COUNT (LT8500_COUNT * CHIP_CHANNEL_COUNT)
+
+// Size of one LT8500 shift frame in bytes (48x 12 bit PWM values + 8 bit command)
+#define CHIP_FRAME_SIZE (CHIP_CHANNEL_COUNT * 12 / 8 + 1)
+#define PACKED_FRAME_SIZE (LT8500_COUNT * CHIP_FRAME_SIZE)
 
 // EEPROM addresses
 #define CALIBRATION_ADDR 0     // Address for calibration data
 
+// Calibration store. Each profile has CAL_SLOT_COUNT slots which are written in turn, so each
+// cell is written once every CAL_SLOT_COUNT saves and a save cut short by a reset leaves the
+// previous record. A record is a header, the profile name and six bit values packed four to
+// three bytes, with a CRC.
+#ifndef CAL_PROFILE_COUNT
+#define CAL_PROFILE_COUNT 4
+#endif
+#ifndef CAL_SLOT_COUNT
+#define CAL_SLOT_COUNT 2
+#endif
+#define CAL_NAME_SIZE 8
+#define CAL_HEADER_SIZE 4
+#define CAL_DATA_SIZE ((SYMBOL_COUNT * 6 + 7) / 8)
+#define CAL_RECORD_SIZE (CAL_HEADER_SIZE + CAL_NAME_SIZE + CAL_DATA_SIZE + 2)
+#define CAL_STORE_SIZE (CAL_PROFILE_COUNT * CAL_SLOT_COUNT * CAL_RECORD_SIZE)
+
+// Splash frame shown by begin, after the calibration store. Magic, display tag, DAC value,
+// eight bit symbol values and a CRC.
+#define SPLASH_ADDR (CALIBRATION_ADDR + CAL_STORE_SIZE)
+#define SPLASH_SIZE (SYMBOL_COUNT + 5)
+
+// Hold LATCH high for the shortest reset the LT8500 accepts (1ms, with a margin), so begin
+// lights the display sooner. Set to 0 for the 100ms pulse of earlier versions.
+#ifndef DATAVU_FAST_BOOT
+#define DATAVU_FAST_BOOT 1
+#endif
+#define LT8500_RESET_US 1100
+
+// Keep a copy of the frame buffer pre-serialized in LT8500 shift order so
+// writeFrame() only streams bytes. Costs PACKED_FRAME_SIZE + SYMBOL_COUNT bytes of RAM.
+#ifndef DATAVU_PACKED_FRAME
+#define DATAVU_PACKED_FRAME 0
+#endif
+
+// Shift frames out from the Timer1 overflow interrupt so writeFrameAsync() returns
+// straight away. Costs 2 * PACKED_FRAME_SIZE bytes of RAM for the front and back buffers.
+#ifndef DATAVU_ASYNC
+#define DATAVU_ASYNC 0
+#endif
+
+// Shift blocking writes twice, reading the first pass back from SDO during the second, and
+// only latch a frame that came back intact. A corrupt frame is sent up to
+// DATAVU_VERIFY_RETRIES more times, then dropped and left for the next writeFrame. Doubles
+// the shift time of blocking writes, writeFrameAsync is not checked.
+#ifndef DATAVU_VERIFY
+#define DATAVU_VERIFY 0
+#endif
+#ifndef DATAVU_VERIFY_RETRIES
+#define DATAVU_VERIFY_RETRIES 2
+#endif
+
+// Keep PWM frame latches out of the last DATAVU_LATCH_GUARD_US, plus 32 PCLK cycles, of a PWM
+// period, so the period boundary a frame is presented at is known, and record it for
+// framePresented(). The chips apply UPDATE_PWM_CMD at the end of a period, a latch close to
+// it may land in either.
+#ifndef DATAVU_LATCH_SYNC
+#define DATAVU_LATCH_SYNC 0
+#endif
+#ifndef DATAVU_LATCH_GUARD_US
+#define DATAVU_LATCH_GUARD_US 16
+#endif
+
+// Spread PCLK by sweeping the Timer2 TOP, OCR2A, up and down by setPwmDither() steps, one
+// step per Timer1 overflow. The period moves so it cannot be used with DATAVU_LATCH_SYNC.
+#ifndef DATAVU_PWM_DITHER
+#define DATAVU_PWM_DITHER 0
+#endif
+#if DATAVU_PWM_DITHER && DATAVU_LATCH_SYNC
+#error "DATAVU_PWM_DITHER moves the PWM period, it cannot be used with DATAVU_LATCH_SYNC"
+#endif
+
+// PCLK is OC2B in fast PWM mode with OCR2A as TOP, F_CPU / (prescale * (OCR2A + 1))
+#define PCLK_MAX_HZ (F_CPU / 2)
+#define PCLK_MIN_HZ (F_CPU / (1024UL * 256))
+#define PWM_PERIOD_CLOCKS 4096
+#if DATAVU_LATCH_SYNC && (F_CPU % 1000000 || PWM_PERIOD_CLOCKS % (F_CPU / 1000000))
+#error "DATAVU_LATCH_SYNC counts PWM periods in whole microseconds, F_CPU must be 1, 2, 4, 8 or 16MHz"
+#endif
+
+// LT8500 status frame, loaded into each shift register when a command is latched. Each
+// channel's twelve bit field has its open LED flag, from the last self test, in the MSB. The
+// command byte is replaced by the status bits.
+#define LT8500_STATUS_OPEN  0x800
+#define LT8500_STATUS_OT    0x01    // Over temperature
+
+// diagnostics() results
+#define DIAG_OPEN_LED   0x01    // A symbol has an open LED
+#define DIAG_OVER_TEMP  0x02    // A chip is over temperature
+#define DIAG_NO_SDO     0x04    // The chain has no SDO pin so nothing was read
+
+// Gamma curves for DATAVU_GAMMA
+#define DATAVU_GAMMA_NONE       0   // frameBuf holds twelve bit PWM values
+#define DATAVU_GAMMA_LINEAR     1   // frameBuf holds eight bit values scaled to twelve bits
+#define DATAVU_GAMMA_SQUARE     2   // Eight bit values, gamma 2
+#define DATAVU_GAMMA_CUBE       3   // Eight bit values, gamma 3
+#define DATAVU_GAMMA_CIE1931    4   // Eight bit values, CIE 1931 lightness
+
+// Map eight bit frame buffer values to twelve bit PWM values when the frame is shifted out.
+// The table is built at compile time and costs 512 bytes of flash.
+#ifndef DATAVU_GAMMA
+#define DATAVU_GAMMA DATAVU_GAMMA_NONE
+#endif
+
+// Largest frame buffer value and the factor from an eight bit value
+#if DATAVU_GAMMA
+#define DATAVU_VALUE_MAX 255
+#else
+#define DATAVU_VALUE_MAX 4095
+#endif
+#define DATAVU_VALUE_SCALE ((DATAVU_VALUE_MAX + 1) / 256)
+
+// Store the frame buffer as eight bit values and expand them to twelve bits as the frame is
+// shifted out. Halves the frame buffer RAM. Frame values keep the 0 to DATAVU_VALUE_MAX range
+// but only the top eight bits of a twelve bit value are kept. Always on with DATAVU_GAMMA.
+#ifndef DATAVU_FRAME_8BIT
+#define DATAVU_FRAME_8BIT 0
+#endif
+
+// Frame buffer entry, and the shift from a frame buffer value to twelve bits
+#if DATAVU_FRAME_8BIT || DATAVU_GAMMA
+typedef uint8_t frame_t;
+#define DATAVU_FRAME_SHIFT 4
+#else
+typedef int frame_t;
+#define DATAVU_FRAME_SHIFT 0
+#endif
+
+// Symbol numbers in SYMBOL_MAP and SEVSEG_MAP, -1 for an unused PWM channel. Profiles with
+// more than 127 symbols set DATAVU_WIDE_SYMBOLS to 1 for sixteen bit symbol numbers.
+#ifndef DATAVU_WIDE_SYMBOLS
+#define DATAVU_WIDE_SYMBOLS 0
+#endif
+#if DATAVU_WIDE_SYMBOLS
+typedef int16_t symbol_t;
+#else
+typedef int8_t symbol_t;
+#endif
+
+// PWM channel number, along the whole chain
+#if PWM_CHANNEL_COUNT > 256
+typedef uint16_t channel_t;
+#else
+typedef uint8_t channel_t;
+#endif
+
+// Channel of a symbol no PWM channel drives. Channels come in whole chips, so it is never used.
+#define NO_CHANNEL ((channel_t)~0)
+
+///////////////////////////////////////////CUSTOM PROFILE//////////////////////////////////////////
+
+// A display profile can be given as a header instead of a board, e.g. compile with
+// -DDATAVU_PROFILE='"myPanel.h"'. The header defines LT8500_COUNT if it is not 2, then
+// DISPLAY_TYPE, SYMBOL_COUNT, DIGIT_COUNT, SYMBOL_MAP and, with digits, SEVSEG_MAP in the
+// same way as the profiles below. The board profiles are then ignored. Digits with decimal
+// points also define SEVSEG_DP_MAP[DIGIT_COUNT] and SEVSEG_HAS_DP as 1.
+#ifdef DATAVU_PROFILE
+#include DATAVU_PROFILE
+#elif LT8500_COUNT != 2
+#error "The Data-Vu board profiles have two LT8500 chips, use a DATAVU_PROFILE header for other counts"
+#endif
+
 ///////////////////////////////////////////NO_DISPLAY//////////////////////////////////////////
 
-#ifdef ARDUINO_NO_DISPLAY
+#if defined(ARDUINO_NO_DISPLAY) && !defined(DATAVU_PROFILE)
 
 #define DISPLAY_TYPE "No Display"
 #define SYMBOL_COUNT 84
 #define DIGIT_COUNT 0
 
-// Define symbol numbering and map to PWM channels
-const int SYMBOL_MAP[PWM_CHANNEL_COUNT] = {
+// Define symbol numbering and map to PWM channels. Stored in flash, read with readSymbol.
+const symbol_t SYMBOL_MAP[PWM_CHANNEL_COUNT] PROGMEM = {
     23, //PWM100
     33, //PWM101
     24, //PWM102
@@ -173,7 +394,7 @@ const int SYMBOL_MAP[PWM_CHANNEL_COUNT] = {
 
 ///////////////////////////////////////////PD01002/4/6/8 - Normal View//////////////////////////////////////////
 
-#ifdef ARDUINO_DATAVU_NORMAL
+#if defined(ARDUINO_DATAVU_NORMAL) && !defined(DATAVU_PROFILE)
 
 #define DISPLAY_TYPE "Normal"
 #define SYMBOL_COUNT 61
@@ -243,8 +464,8 @@ const int SYMBOL_MAP[PWM_CHANNEL_COUNT] = {
 #define S12 60
 #define XXX -1 // Not connected to a symbol
 
-// Define symbol numbering and map to PWM channels
-const int SYMBOL_MAP[PWM_CHANNEL_COUNT] = {
+// Define symbol numbering and map to PWM channels. Stored in flash, read with readSymbol.
+const symbol_t SYMBOL_MAP[PWM_CHANNEL_COUNT] PROGMEM = {
     XXX, //PWM100
     A02, //PWM101
     XXX, //PWM102
@@ -343,8 +564,8 @@ const int SYMBOL_MAP[PWM_CHANNEL_COUNT] = {
     XXX  //PWM247
 };
 
-// Seven segment display mapping
-const int SEVSEG_MAP[DIGIT_COUNT][7] = {
+// Seven segment display mapping. Stored in flash, read with readSymbol.
+const symbol_t SEVSEG_MAP[DIGIT_COUNT][7] PROGMEM = {
     
     // Digit 0
     {       // 7-Segment Map
@@ -417,7 +638,7 @@ const int SEVSEG_MAP[DIGIT_COUNT][7] = {
 
 ///////////////////////////////////////////PD01003/5/7/9 - Inverted View//////////////////////////////////////////
 
-#ifdef ARDUINO_DATAVU_INVERTED
+#if defined(ARDUINO_DATAVU_INVERTED) && !defined(DATAVU_PROFILE)
 
 #define DISPLAY_TYPE "Inverted"
 #define SYMBOL_COUNT 61
@@ -487,8 +708,8 @@ const int SEVSEG_MAP[DIGIT_COUNT][7] = {
 #define S12 60
 #define XXX -1 // Not connected to a symbol
 
-// Define symbol numbering and map to PWM channels
-const int SYMBOL_MAP[PWM_CHANNEL_COUNT] = {
+// Define symbol numbering and map to PWM channels. Stored in flash, read with readSymbol.
+const symbol_t SYMBOL_MAP[PWM_CHANNEL_COUNT] PROGMEM = {
     N3F, //PWM100
     N0B, //PWM101
     XXX, //PWM102
@@ -587,8 +808,8 @@ const int SYMBOL_MAP[PWM_CHANNEL_COUNT] = {
     XXX  //PWM247
 };
 
-// Seven segment display mapping
-const int SEVSEG_MAP[DIGIT_COUNT][7] = {
+// Seven segment display mapping. Stored in flash, read with readSymbol.
+const symbol_t SEVSEG_MAP[DIGIT_COUNT][7] PROGMEM = {
     
     // Digit 0
     {       // 7-Segment Map
@@ -659,6 +880,43 @@ const int SEVSEG_MAP[DIGIT_COUNT][7] = {
 
 #endif
 
+/**
+    Read a symbol number from SYMBOL_MAP or SEVSEG_MAP
+*/
+static inline int16_t readSymbol(const symbol_t *p) {
+#if DATAVU_WIDE_SYMBOLS
+    return (int16_t)pgm_read_word(p);
+#else
+    return (int8_t)pgm_read_byte(p);
+#endif
+}
+
+// Bytes of a symbol mask for updateMasked, one bit per symbol, symbol 0 in bit 0 of byte 0
+#define SYMBOL_MASK_SIZE ((SYMBOL_COUNT + 7) / 8)
+
+/**
+    Frame buffer entry for a frame value
+*/
+static inline frame_t toFrame(int val) {
+#if DATAVU_GAMMA
+    return val;
+#else
+    return val >> DATAVU_FRAME_SHIFT;
+#endif
+}
+
+/**
+    Frame value of a frame buffer entry. Eight bit entries of twelve bit values repeat their
+    top bits in the low bits so 255 reads back as 4095.
+*/
+static inline int fromFrame(frame_t entry) {
+#if DATAVU_GAMMA || !DATAVU_FRAME_SHIFT
+    return entry;
+#else
+    return (entry << 4) | (entry >> 4);
+#endif
+}
+
 // Only needed for devices with seven segment displays
 #if DIGIT_COUNT > 0
 
@@ -794,31 +1052,300 @@ const uint8_t CHARACTERARRAY[] PROGMEM = {
     0b0000000, // 126 '~'  NO DISPLAY
     0b0000000, // 127 'DEL'  NO DISPLAY
 };
+
+// Decimal point symbols, set by profiles whose digits have them
+#ifndef SEVSEG_HAS_DP
+#define SEVSEG_HAS_DP 0
+#endif
+
+// Powers of ten for displayNumber, one more than the digits
+const uint32_t POWERS_OF_TEN[] PROGMEM = {
+    1, 10, 100, 1000, 10000, 100000, 1000000, 10000000, 100000000, 1000000000
+};
+static_assert(DIGIT_COUNT < 10, "displayNumber needs a power of ten above the largest number");
 #endif
 
-// Logan class prototype
-class DataVu
+// Placement of a number on the seven segment digits
+#define NUMBER_RIGHT    0   // Right justified, leading zeros blanked
+#define NUMBER_LEFT     1   // Left justified, trailing digits blanked
+#define NUMBER_ZEROS    2   // Leading zeros shown on every digit
+
+/*
+    Serial pin functions of a chain, filled in by DataVuChain for its port. DataVuBase calls
+    them through these pointers instead of virtual functions, as avr-gcc keeps vtables in RAM.
+*/
+struct DataVuPinOps
 {
-        // Flag for the state of calibration feature
-        int calState;
+    void (*shiftBytes)(const uint8_t*, int);
+    uint8_t (*shiftRead)(const uint8_t*, uint8_t*, int);
+    void (*latch)(void);
+    void (*setLatch)(bool);
+    bool hasSdo;
+};
+
+/*
+    Display driver. Holds the frame buffer and everything that does not depend on the port the
+    LT8500 chain is wired to, so it is compiled once however many chains there are. Use
+    DataVu for the Data-Vu board or DataVuChain for a chain on other pins.
+*/
+class DataVuBase
+{
+        // Shadow of the chips' configuration and the configuration asked for, CHIP_* flags
+        uint8_t chipConfig;
+        uint8_t wantConfig;
+        
+        // Correction values packed as in the EEPROM. calSet once writeCal has set them, calLoaded
+        // while the chips hold them.
+        uint8_t calShadow[CAL_DATA_SIZE];
+        bool calSet;
+        bool calLoaded;
+        
+        // Frame buffer has changed since it was last written
+        volatile bool frameDirty;
+        
+        // Number of writes skipped because nothing changed
+        unsigned long skippedWrites;
+        
+        // Number of shifts that did not read back intact
+        unsigned long verifyErrors;
+        
+#if DATAVU_LATCH_SYNC
+        // Start of a PWM period of the chips, moved up to the period in progress at each
+        // latch, in micros() and millis() time, and the end of the period the last frame is
+        // shown in
+        uint32_t pwmEpoch;
+        uint32_t pwmEpochMs;
+        volatile uint32_t presentedUs;
+#endif
+        
+        // Master brightness applied to every channel as the frame is shifted out
+        uint8_t brightness;
         
     public:
     
-        // Software frame buffer
-        int frameBuf[SYMBOL_COUNT];
-    
         // Member functions
-        DataVu(void);
         void begin(void);
         int setVoltage(float);
         int updateFrame(int);
         int updateSymbol(int, int);
-        void writeFrame();
+        int getSymbol(int);
+        int loadFrame(const uint16_t*);
+        int loadFrame_P(const uint16_t*);
+        int fillRange(int, int, int);
+        int updateMasked(const uint8_t*, int);
+        void writeFrame(bool force = false);
+        void writeFrameAsync(bool force = false);
+        unsigned long getSkippedWrites();
+        unsigned long getVerifyErrors();
+        int diagnostics(uint8_t *openLeds = NULL);
+        bool isBusy();
+        unsigned long setPwmClock(unsigned long);
+        unsigned long getPwmClock();
+        float setRefreshRate(float);
+        unsigned long getPwmPeriod();
+#if DATAVU_PWM_DITHER
+        int setPwmDither(uint8_t);
+#endif
+#if DATAVU_LATCH_SYNC
+        unsigned long framePresented();
+#endif
+        void onFrameSent(void (*)(void));
+        void setMasterBrightness(uint8_t);
+        uint8_t getMasterBrightness();
         void setCal(bool);
+        void setPhaseShift(bool);
+        void setOutputs(bool);
+        int setConfig(uint8_t);
+        uint8_t getConfig();
         int writeCal(int*, bool save = false);
+        int saveCal(int*, uint8_t, const char *name = NULL);
+        int readCal(int*, uint8_t, char *name = NULL);
+        int loadCal(uint8_t);
+        int findCal(const char*);
+        uint8_t getCalProfile();
+        void saveSplash(void);
+        void clearSplash(void);
         void resetChips();
+        void resync();
         int updateDigit(char, int, int);
+        int displayNumber(int32_t, uint8_t decimals = 0, uint8_t justify = NUMBER_RIGHT, int val = DATAVU_VALUE_MAX);
+        int displayHex(uint32_t, uint8_t justify = NUMBER_RIGHT, int val = DATAVU_VALUE_MAX);
+        
+#if DATAVU_ASYNC
+        static void txService();
+#endif
+        
+    protected:
+        DataVuBase(const DataVuPinOps&);
+        
+    private:
+    
+        // Serial pins of the chain
+        DataVuPinOps pins;
+        
+        // Software frame buffer, entries converted with toFrame and fromFrame
+        frame_t frameBuf[SYMBOL_COUNT];
+        
+        // Calibration profile loaded into the chips and saved by writeCal
+        uint8_t calProfile;
+        
+        inline void setEntry(int, frame_t);
+        void showDigits(const uint8_t*, int8_t, frame_t);
+        bool readSplash(void);
+        bool applyConfig(uint8_t);
+        void sendCal();
+        bool writeCommand(int);
+        bool writeChips(int, frame_t*);
+        void packChip(uint8_t*, int, frame_t*, uint8_t);
+        bool claimFrame(bool);
+        void sendFrame();
+        void latchFrame();
+        uint32_t latchWhenClear();
+        
+#if DATAVU_LATCH_SYNC
+        uint32_t pwmPeriodLeft(uint32_t, uint32_t&);
+#endif
+        
+#if DATAVU_VERIFY
+        bool checkChips(int, frame_t*, const uint8_t*);
+#endif
+        
+#if DATAVU_ASYNC && !DATAVU_PACKED_FRAME
+        void packFrame(uint8_t*, int, frame_t*);
+#endif
+        
+#if DATAVU_PACKED_FRAME
+        // Frame buffer serialized in LT8500 shift order, command bytes included
+        uint8_t frameBits[PACKED_FRAME_SIZE];
+        
+        // PWM channel driving each symbol
+        channel_t symbolChannel[SYMBOL_COUNT];
+        
+        void packSymbol(int);
+        void writePacked(const uint8_t*, int);
+#endif
+};
+
+/*
+    LT8500 chain on the port and pins given by PINS, see DATAVU_PINS. Only the serialization
+    kernel is compiled for each port.
+*/
+template<class PINS>
+class DataVuChain : public DataVuBase
+{
+    public:
+        DataVuChain(void);
         
     private:
-        void write2Chips(int, int*);
+        static void shiftBytes(const uint8_t*, int);
+        static uint8_t shiftRead(const uint8_t*, uint8_t*, int);
+        static void latch(void);
+        static void setLatch(bool);
+        static uint8_t portBase();
 };
+
+// Display driver of the Data-Vu board
+typedef DataVuChain<DataVuPortD> DataVu;
+
+/**
+    Class constructor. Sets up the serial pins of the chain.
+*/
+template<class PINS>
+DataVuChain<PINS>::DataVuChain(void) : DataVuBase({shiftBytes, shiftRead, latch, setLatch, PINS::SDO != 0}) {
+    PINS::ddr() |= PINS::SDI | PINS::SCKI | PINS::LATCH;
+    PINS::ddr() &= ~PINS::SDO;
+    PINS::port() &= ~(PINS::SDI | PINS::SCKI | PINS::LATCH);
+}
+
+/**
+    Port value with the serial pins low. Read again for each byte with interrupts masked, so
+    other pins of the port changed by an ISR between bytes are not written back.
+*/
+template<class PINS>
+inline uint8_t DataVuChain<PINS>::portBase() {
+    return PINS::port() & ~(PINS::LATCH | PINS::SDI | PINS::SCKI);
+}
+
+/**
+    Shift bytes to the PWM chips - MSB first. Every bit is two stores to the port, the first
+    sets SDI with SCKI low and the second raises SCKI.
+*/
+template<class PINS>
+void DataVuChain<PINS>::shiftBytes(const uint8_t *bits, int count) {
+    const uint8_t *end = bits + count;
+    while (bits != end) {
+        uint8_t sreg = SREG;
+        cli();
+        uint8_t lo = portBase();
+        uint8_t hi = lo | PINS::SDI;
+        uint8_t data = *bits++;
+        for (uint8_t mask = 0x80; mask; mask >>= 1) {
+            uint8_t out = (data & mask) ? hi : lo;
+            PINS::port() = out;
+            PINS::port() = out | PINS::SCKI;
+        }
+        SREG = sreg;
+    }
+}
+
+/**
+    Shift bytes to the PWM chips while reading the bits that drop out of the last chip on SDO.
+    Stores them in sdo unless it is NULL and returns the bits that differ from those shifted in
+    OR'd together. Slower than shiftBytes, SDO is sampled with SCKI low before each rising edge.
+*/
+template<class PINS>
+uint8_t DataVuChain<PINS>::shiftRead(const uint8_t *bits, uint8_t *sdo, int count) {
+    uint8_t diff = 0;
+    for (int i = 0; i < count; i++) {
+        uint8_t sreg = SREG;
+        cli();
+        uint8_t lo = portBase();
+        uint8_t hi = lo | PINS::SDI;
+        uint8_t in = 0;
+        for (uint8_t mask = 0x80; mask; mask >>= 1) {
+            uint8_t out = (bits[i] & mask) ? hi : lo;
+            PINS::port() = out;
+            if (PINS::pin() & PINS::SDO) {
+                in |= mask;
+            }
+            PINS::port() = out | PINS::SCKI;
+        }
+        SREG = sreg;
+        if (sdo) {
+            sdo[i] = in;
+        }
+        diff |= in ^ bits[i];
+    }
+    
+    // Nothing to compare without an SDO pin
+    return PINS::SDO != 0 ? diff : 0;
+}
+
+/**
+    End a frame. Set SDI and SCKI low and pulse the latch.
+*/
+template<class PINS>
+void DataVuChain<PINS>::latch(void) {
+    uint8_t sreg = SREG;
+    cli();
+    uint8_t lo = portBase();
+    PINS::port() = lo;
+    PINS::port() = lo | PINS::LATCH;
+    PINS::port() = lo;
+    SREG = sreg;
+}
+
+/**
+    Set the latch pin, held high for a reset
+*/
+template<class PINS>
+void DataVuChain<PINS>::setLatch(bool state) {
+    if (state) {
+        PINS::port() |= PINS::LATCH;
+    }
+    else {
+        PINS::port() &= ~PINS::LATCH;
+    }
+}
+
+#endif //DATAVULIB_H
@@ -0,0 +1,65 @@
+/******************************************************************************
+    This file an example of the animation sequencer of the Data-Vu evaluation
+    kit library created by Plessey Semiconductors.
+
+    Copyright (C) 2019  <Gethn Pickard>
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <https://www.gnu.org/licenses/>.
+******************************************************************************/
+
+#include <dataVuLib.h>
+#include <dataVuAnim.h>
+
+// Create dataVu and animation objects
+DataVu dataVu;
+DataVuAnim anim(dataVu);
+
+// Chase the first four symbols three times, fade symbol 0 out, then flash the
+// whole display forever
+const uint8_t timeline[] PROGMEM = {
+    ANIM_FILL(0),
+    ANIM_LOOP(3),
+        ANIM_SET(0, 255), ANIM_SET(3, 0),   ANIM_HOLD(10),
+        ANIM_SET(1, 255), ANIM_SET(0, 0),   ANIM_HOLD(10),
+        ANIM_SET(2, 255), ANIM_SET(1, 0),   ANIM_HOLD(10),
+        ANIM_SET(3, 255), ANIM_SET(2, 0),   ANIM_HOLD(10),
+    ANIM_ENDLOOP(),
+    ANIM_SET(3, 0), ANIM_SET(0, 255),
+    ANIM_LOOP(15),
+        ANIM_ADD(0, -17), ANIM_SHOW(),
+    ANIM_ENDLOOP(),
+    ANIM_LOOP(0),
+        ANIM_FILL(20), ANIM_HOLD(25),
+        ANIM_FILL(0),  ANIM_HOLD(25),
+    ANIM_ENDLOOP(),
+    ANIM_END()
+};
+
+void setup() {
+
+    // Initialize object
+    dataVu.begin();
+
+    // Set voltage
+    dataVu.setVoltage(2.7);
+
+    // Play the timeline at 50 frames per second
+    anim.start(timeline, 20);
+}
+
+void loop() {
+
+    // Step the animation. DATAVU_ANIM_ISR() would run it from a timer interrupt instead.
+    anim.update();
+}
@@ -45,16 +45,11 @@ void loop() {
     int seconds = 0;
     for (int i = 0; i < 100; i++) {
 
-        // Calculate digits
-        int D1 = i % 10;
-        int D2 = i / 10;
-
         // Clear frame buffer
         dataVu.updateFrame(0);
 
-        // Write digits to frame buffer
-        dataVu.updateDigit(D1, 0, 5);
-        dataVu.updateDigit(D2, 1, 5);
+        // Write number to frame buffer
+        dataVu.displayNumber(i, 0, NUMBER_RIGHT, 5);
 
         // Update display and wait for one second
         dataVu.writeFrame();
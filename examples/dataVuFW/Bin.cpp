@@ -0,0 +1,216 @@
+/******************************************************************************
+    This file implements the binary frame protocol of the Data-Vu evaluation
+    kit Firmware created by Plessey Semiconductors.
+
+    Copyright (C) 2019  <Gethn Pickard>
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <https://www.gnu.org/licenses/>.
+******************************************************************************/
+
+/*
+    Packets are COBS encoded and terminated with a zero byte. Once decoded a
+    packet is:
+
+        <type> <seq> <payload ...> <crc low> <crc high>
+
+    The CRC is CRC-16/MCRF4XX (avr-libc _crc_ccitt_update, initial value
+    0xFFFF) over the type, sequence number and payload. Every packet is
+    answered with a COBS encoded <status> <seq> <crc low> <crc high>. A packet
+    with the same sequence number as the last accepted packet is a retry and
+    is acknowledged without being applied again.
+*/
+
+#include <Arduino.h>
+#include <util/crc16.h>
+#include "Bin.h"
+
+// Decoded packet buffer - type, sequence number, payload and CRC
+static uint8_t pkt[BIN_MAX_PAYLOAD + 4];
+static uint8_t pkt_len;
+
+// COBS decoder state
+static uint8_t block_code;      // Code byte of the current block
+static uint8_t block_left;      // Bytes left in the current block
+static bool block_first = true; // Next code byte starts a packet
+static bool pkt_overflow;
+
+// Sequence number of the last accepted packet
+static uint8_t last_seq;
+static bool last_seq_valid;
+
+// Packet handler supplied by the sketch
+static int (*bin_handler)(uint8_t type, uint8_t *data, uint8_t len);
+
+static bool active = false;
+
+/**
+    CRC of a buffer
+*/
+static uint16_t bin_crc(const uint8_t *data, uint8_t len)
+{
+    uint16_t crc = 0xFFFF;
+    for (uint8_t i = 0; i < len; i++) {
+        crc = _crc_ccitt_update(crc, data[i]);
+    }
+    return crc;
+}
+
+/**
+    COBS encode a short buffer and send it with a zero terminator
+*/
+static void bin_send(const uint8_t *data, uint8_t len)
+{
+    uint8_t start = 0;
+    for (uint8_t i = 0; i <= len; i++) {
+        if (i == len || data[i] == 0) {
+            Serial.write(i - start + 1);
+            Serial.write(data + start, i - start);
+            start = i + 1;
+        }
+    }
+    Serial.write((uint8_t)0);
+}
+
+/**
+    Send the reply for a packet
+*/
+static void bin_reply(uint8_t status, uint8_t seq)
+{
+    uint8_t reply[4] = {status, seq};
+    uint16_t crc = bin_crc(reply, 2);
+    reply[2] = crc;
+    reply[3] = crc >> 8;
+    bin_send(reply, sizeof(reply));
+}
+
+/**
+    Check and apply a decoded packet
+*/
+static void bin_packet()
+{
+    // Type, sequence number and CRC at least
+    if (pkt_len < 4) {
+        return;
+    }
+
+    uint8_t type = pkt[0];
+    uint8_t seq = pkt[1];
+    uint8_t len = pkt_len - 4;
+
+    // Check CRC
+    uint16_t crc = pkt[pkt_len - 2] | (pkt[pkt_len - 1] << 8);
+    if (crc != bin_crc(pkt, pkt_len - 2)) {
+        bin_reply(BIN_ERR_CRC, seq);
+        return;
+    }
+
+    // Retry of a packet that was already applied
+    if (last_seq_valid && seq == last_seq) {
+        bin_reply(BIN_OK, seq);
+        return;
+    }
+
+    // Apply packet
+    uint8_t status = BIN_OK;
+    if (type == BIN_EXIT) {
+        active = false;
+    }
+    else {
+        status = bin_handler(type, pkt + 2, len);
+    }
+
+    if (status == BIN_OK) {
+        last_seq = seq;
+        last_seq_valid = true;
+    }
+    bin_reply(status, seq);
+}
+
+/**
+    Process a received byte
+*/
+static void bin_rx(uint8_t c)
+{
+    // End of packet
+    if (c == 0) {
+        if (!pkt_overflow) {
+            bin_packet();
+        }
+        pkt_len = 0;
+        block_left = 0;
+        block_first = true;
+        pkt_overflow = false;
+        return;
+    }
+
+    // Start of a block. Blocks shorter than 255 bytes stand for a zero before the next block.
+    if (block_left == 0) {
+        if (!block_first && block_code != 0xFF) {
+            if (pkt_len < sizeof(pkt)) {
+                pkt[pkt_len++] = 0;
+            }
+            else {
+                pkt_overflow = true;
+            }
+        }
+        block_code = c;
+        block_left = c - 1;
+        block_first = false;
+        return;
+    }
+
+    // Data byte
+    if (pkt_len < sizeof(pkt)) {
+        pkt[pkt_len++] = c;
+    }
+    else {
+        pkt_overflow = true;
+    }
+    block_left--;
+}
+
+/**
+    Enter binary mode. Packets other than BIN_EXIT are passed to the handler,
+    which returns one of the reply status codes.
+*/
+void binBegin(int (*handler)(uint8_t type, uint8_t *data, uint8_t len))
+{
+    bin_handler = handler;
+    pkt_len = 0;
+    block_left = 0;
+    block_first = true;
+    pkt_overflow = false;
+    last_seq_valid = false;
+    active = true;
+}
+
+/**
+    Check if binary mode is active
+*/
+bool binActive()
+{
+    return active;
+}
+
+/**
+    This function should be called from the main loop instead of cmdPoll()
+    while binary mode is active.
+*/
+void binPoll()
+{
+    while (active && Serial.available())
+    {
+        bin_rx(Serial.read());
+    }
+}
@@ -0,0 +1,46 @@
+/******************************************************************************
+    This file is the header file for the binary frame protocol of the Data-Vu
+    evaluation kit Firmware created by Plessey Semiconductors.
+
+    Copyright (C) 2019  <Gethn Pickard>
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <https://www.gnu.org/licenses/>.
+******************************************************************************/
+
+#ifndef BIN_H
+#define BIN_H
+
+#include <stdint.h>
+
+// Largest packet payload. A 12 bit frame for an 84 symbol display is 126 bytes.
+#define BIN_MAX_PAYLOAD 128
+
+// Packet types
+#define BIN_FRAME8      0x01    // SYMBOL_COUNT eight bit values
+#define BIN_FRAME12     0x02    // SYMBOL_COUNT twelve bit values, two values per three bytes
+#define BIN_WRITE       0x03    // Write the frame buffer to the display
+#define BIN_EXIT        0x7F    // Leave binary mode and return to the CLI
+#define BIN_LATCH       0x80    // Flag - write the frame buffer once the packet is applied
+
+// Reply status codes
+#define BIN_OK          0x00
+#define BIN_ERR_CRC     0x01
+#define BIN_ERR_LENGTH  0x02
+#define BIN_ERR_TYPE    0x03
+
+void binBegin(int (*handler)(uint8_t type, uint8_t *data, uint8_t len));
+bool binActive();
+void binPoll();
+
+#endif //BIN_H
@@ -54,16 +54,71 @@
 static uint8_t msg[MAX_MSG_SIZE];
 static uint8_t *msg_ptr;
 
-// linked list for command table
-static cmd_t *cmd_tbl_list, *cmd_tbl;
+// command table (stored in flash)
+static const cmd_t *cmd_tbl;
+static uint8_t cmd_count;
+
+// streaming argument state. stream_cmd is NULL while a line is being buffered.
+static const cmd_t *stream_cmd;
+static uint8_t stream_argc;
+static uint16_t stream_val;
+static uint8_t stream_digits;
+static bool stream_err;
 
 // text strings for command prompt (stored in flash)
 const char cmd_banner[] PROGMEM = "*******DataVu Driver CLI******";
 
+/**************************************************************************/
+/*!
+    Binary search the sorted command table for a command name. Returns NULL
+    if the command is not in the table.
+*/
+/**************************************************************************/
+static const cmd_t *cmd_find(const char *name)
+{
+    uint8_t lo = 0, hi = cmd_count;
+    while (lo < hi)
+    {
+        uint8_t mid = (lo + hi) / 2;
+        int cmp = strcmp_P(name, cmd_tbl[mid].cmd);
+        if (cmp == 0)
+        {
+            return &cmd_tbl[mid];
+        }
+        else if (cmp < 0)
+        {
+            hi = mid;
+        }
+        else
+        {
+            lo = mid + 1;
+        }
+    }
+    return NULL;
+}
+
+/**************************************************************************/
+/*!
+    Print the result of a command and re-generate the prompt.
+*/
+/**************************************************************************/
+static void cmd_result(bool err)
+{
+    if (err)
+    {
+        Serial.println(CMD_ERROR);
+    }
+    else
+    {
+        Serial.println();
+    }
+    Serial.print(CMD_PROMPT);
+}
+
 /**************************************************************************/
 /*!
     Parse the command line. This function tokenizes the command input, then
-    searches for the command table entry associated with the commmand. Once found,
+    binary searches the sorted command table for the commmand. Once found,
     it will jump to the corresponding function.
 */
 /**************************************************************************/
@@ -71,7 +126,6 @@ void cmd_parse(char *cmd)
 {
     uint8_t argc, i = 0;
     char *argv[ARGUMENT_SIZE];
-    cmd_t *cmd_entry;
 
     fflush(stdout);
 
@@ -81,39 +135,120 @@ void cmd_parse(char *cmd)
     do
     {
         argv[++i] = strtok(NULL, " ");
-    } while ((i < 65) && (argv[i] != NULL));
+    } while ((i < ARGUMENT_SIZE - 1) && (argv[i] != NULL));
     
     // save off the number of arguments for the particular command.
     argc = i;
 
-    // parse the command table for valid command. used argv[0] which is the
+    // empty line. just re-generate the prompt.
+    if (argv[0] == NULL)
+    {
+        cmd_result(false);
+        return;
+    }
+
+    // search the command table for valid command. used argv[0] which is the
     // actual command name typed in at the prompt
-    for (cmd_entry = cmd_tbl; cmd_entry != NULL; cmd_entry = cmd_entry->next)
+    const cmd_t *entry = cmd_find(argv[0]);
+    if (entry == NULL)
+    {
+        // command not recognized. print message and re-generate prompt.
+        cmd_result(true);
+        return;
+    }
+
+    int (*func)(int argc, char **argv) = (int (*)(int, char **))pgm_read_ptr(&entry->func);
+    cmd_result(func(argc, argv));
+}
+
+/**************************************************************************/
+/*!
+    Hand the number being streamed to the command's arg function. Nothing is
+    passed on if no digits have arrived since the last separator.
+*/
+/**************************************************************************/
+static void cmd_stream_arg()
+{
+    if (stream_digits == 0)
+    {
+        return;
+    }
+
+    int (*arg)(uint8_t index, uint16_t value) = (int (*)(uint8_t, uint16_t))pgm_read_ptr(&stream_cmd->arg);
+    if (!stream_err && arg(stream_argc - 1, stream_val))
+    {
+        stream_err = true;
+    }
+    stream_argc++;
+    stream_val = 0;
+    stream_digits = 0;
+}
+
+/**************************************************************************/
+/*!
+    Process a character typed after the name of a streaming command. Digits
+    are accumulated into the current number, a space completes it and enter
+    completes the command. Backspace can only edit the current number.
+*/
+/**************************************************************************/
+static void cmd_stream(char c)
+{
+    switch (c)
     {
-        if (!strcmp(argv[0], cmd_entry->cmd))
+    case '\r':
+        cmd_stream_arg();
+        if (stream_err)
         {
-            if (cmd_entry->func(argc, argv)) {
-              Serial.println(CMD_ERROR);
-              Serial.print(CMD_PROMPT);
-            }
-            else {
-              Serial.println();
-              Serial.print(CMD_PROMPT);
-            }
-            return;
+            cmd_result(true);
         }
-    }
+        else
+        {
+            // msg still holds the command name
+            char *argv[2] = {(char *)msg, NULL};
+            int (*func)(int argc, char **argv) = (int (*)(int, char **))pgm_read_ptr(&stream_cmd->func);
+            cmd_result(func(stream_argc, argv));
+        }
+        stream_cmd = NULL;
+        msg_ptr = msg;
+        break;
 
-    // command not recognized. print message and re-generate prompt.
-    Serial.println(CMD_ERROR);
-    Serial.print(CMD_PROMPT);
+    case ' ':
+        Serial.print(c);
+        cmd_stream_arg();
+        break;
+
+    case 127:
+        // backspace
+        if (stream_digits > 0)
+        {
+            Serial.print(c);
+            stream_val /= 10;
+            stream_digits--;
+        }
+        break;
+
+    default:
+        Serial.print(c);
+        if (c >= '0' && c <= '9' && stream_val < 1000)
+        {
+            stream_val = stream_val * 10 + (c - '0');
+            stream_digits++;
+        }
+        else
+        {
+            // not a number or too large. the rest of the line is ignored.
+            stream_err = true;
+        }
+        break;
+    }
 }
 
 /**************************************************************************/
 /*!
     This function processes the individual characters typed into the command
     prompt. It saves them off into the message buffer unless its a "backspace"
-    or "enter" key. 
+    or "enter" key. Once the name of a command with an arg function is
+    complete the rest of the line is streamed instead of buffered.
 */
 /**************************************************************************/
 void cmd_handler()
@@ -121,6 +256,12 @@ void cmd_handler()
     char c = Serial.read();
     //Serial.println(int(c));
 
+    if (stream_cmd != NULL)
+    {
+        cmd_stream(c);
+        return;
+    }
+
     switch (c)
     {
     case '\r':
@@ -152,10 +293,39 @@ void cmd_handler()
 //        }
 //        break;
 //    
+    case ' ':
+        // leading spaces are dropped
+        if (msg_ptr == msg)
+        {
+            Serial.print(c);
+            break;
+        }
+
+        // end of the command name. check if it takes streamed arguments.
+        if (memchr(msg, ' ', msg_ptr - msg) == NULL)
+        {
+            *msg_ptr = '\0';
+            const cmd_t *entry = cmd_find((char *)msg);
+            if (entry != NULL && pgm_read_ptr(&entry->arg) != NULL)
+            {
+                Serial.print(c);
+                stream_cmd = entry;
+                stream_argc = 1;
+                stream_val = 0;
+                stream_digits = 0;
+                stream_err = false;
+                break;
+            }
+        }
+        // fall through
+
     default:
         // normal character entered. add it to the buffer
         Serial.print(c);
-        *msg_ptr++ = c;
+        if (msg_ptr < msg + MAX_MSG_SIZE - 1)
+        {
+            *msg_ptr++ = c;
+        }
         break;
     }
 }
@@ -177,16 +347,19 @@ void cmdPoll()
 /**************************************************************************/
 /*!
     Initialize the command line interface. This sets the terminal speed and
-    and initializes things. 
+    and initializes things. The command table must be stored in flash and
+    sorted by name, check it with static_assert(cmdSorted(...)).
 */
 /**************************************************************************/
-void cmdInit(uint32_t speed)
+void cmdInit(uint32_t speed, const cmd_t *table, uint8_t count)
 {
     // init the msg ptr
     msg_ptr = msg;
+    stream_cmd = NULL;
 
     // init the command table
-    cmd_tbl_list = NULL;
+    cmd_tbl = table;
+    cmd_count = count;
 
     // set the serial speed
     Serial.begin(speed);
@@ -198,33 +371,6 @@ void cmdInit(uint32_t speed)
     Serial.print(CMD_PROMPT);
 }
 
-/**************************************************************************/
-/*!
-    Add a command to the command table. The commands should be added in
-    at the setup() portion of the sketch. 
-*/
-/**************************************************************************/
-void cmdAdd(char *name, int (*func)(int argc, char **argv))
-{
-    // alloc memory for command struct
-    cmd_tbl = (cmd_t *)malloc(sizeof(cmd_t));
-
-    // alloc memory for command name
-    char *cmd_name = (char *)malloc(strlen(name)+1);
-
-    // copy command name
-    strcpy(cmd_name, name);
-
-    // terminate the command name
-    cmd_name[strlen(name)] = '\0';
-
-    // fill out structure
-    cmd_tbl->cmd = cmd_name;
-    cmd_tbl->func = func;
-    cmd_tbl->next = cmd_tbl_list;
-    cmd_tbl_list = cmd_tbl;
-}
-
 /**************************************************************************/
 /*!
     Convert a string to a number. The base must be specified, ie: "32" is a
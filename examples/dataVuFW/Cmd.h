@@ -44,24 +44,41 @@
 #ifndef CMD_H
 #define CMD_H
 
-#define MAX_MSG_SIZE    350
+#define MAX_MSG_SIZE    64
 #include <stdint.h>
 
 #define CMD_PROMPT '>'
 #define CMD_ERROR '?'
-#define ARGUMENT_SIZE 200
+#define ARGUMENT_SIZE 8     // command + arguments + terminator
+#define CMD_NAME_SIZE 8     // longest command name + 1
 
-// command line structure
-typedef struct _cmd_t
+// command table entry. the table lives in flash and must be sorted by name.
+// commands with an arg function take unsigned decimal arguments which are
+// converted as they arrive and passed to arg one at a time instead of being
+// buffered. func is then called at the end of the line with argc counting the
+// arguments and argv holding only the command name.
+typedef struct
 {
-    char *cmd;
+    char cmd[CMD_NAME_SIZE];
     int (*func)(int argc, char **argv);
-    struct _cmd_t *next;
+    int (*arg)(uint8_t index, uint16_t value);
 } cmd_t;
 
-void cmdInit(uint32_t speed);
+// compile time check that a command table is sorted, for use with static_assert
+constexpr int cmdCompare(const char *a, const char *b)
+{
+    return (*a != *b || *a == '\0') ? *a - *b : cmdCompare(a + 1, b + 1);
+}
+
+constexpr bool cmdSorted(const cmd_t *table, unsigned count)
+{
+    return count < 2 || (cmdCompare(table[0].cmd, table[1].cmd) < 0 && cmdSorted(table + 1, count - 1));
+}
+
+#define CMD_COUNT(table) (sizeof(table) / sizeof(table[0]))
+
+void cmdInit(uint32_t speed, const cmd_t *table, uint8_t count);
 void cmdPoll();
-void cmdAdd(char *name, int (*func)(int argc, char **argv));
 uint32_t cmdStr2Num(char *str, uint8_t base);
 
 #endif //CMD_H
@@ -24,6 +24,7 @@
 // Include libraries
 #include <dataVuLib.h>
 #include "Cmd.h"
+#include "Bin.h"
 
 // Help command string
 const char COMMAND_LIST[] PROGMEM = {
@@ -39,6 +40,14 @@ const char COMMAND_LIST[] PROGMEM = {
     cOn                                                 Turns on the calibration mode \n\r\
     cOff                                                Turns off the calibration mode \n\r\
     c <cal_1> <cal_2> ... <cal_SYMBOL_COUNT>            Write the calibration values and save them to EEPROM \n\r\
+    cp <profile>                                        Loads a saved calibration profile (0-3), later c commands save to it \n\r\
+    cn <name>                                           Names the loaded calibration profile \n\r\
+    s                                                   Saves the frame buffer and voltage as the splash frame shown at power on \n\r\
+    sc                                                  Clears the splash frame \n\r\
+    d                                                   Runs the LED driver self test and prints faults and open LED symbols \n\r\
+    r <rate>                                            Sets the PWM refresh rate in Hz and prints the rate set \n\r\
+    m                                                   Prints the most stack used since power on and the RAM never reached \n\r\
+    b                                                   Enters binary frame mode, see README for the packet format \n\r\
 "};
 
 // Create DataVu object
@@ -50,40 +59,58 @@ DataVu dataVu;
 #define HOLD_TIME 1000
 #define VALUE_COUNT 10
 
+// Size of a binary 12 bit frame - two values per three bytes
+#define FRAME12_SIZE ((SYMBOL_COUNT * 3 + 1) / 2)
+
 // Initialize button variables
 volatile int counter = 0;
 volatile bool state = false;
 volatile long lastTime = 0;
 volatile long currTime = 0;
+#if DATAVU_GAMMA
+int values[VALUE_COUNT] = {16, 32, 48, 64, 96, 128, 160, 192, 224, 255};
+#else
 int values[VALUE_COUNT] = {1, 5, 10, 20, 50, 100, 250, 500, 2000, 4095}; 
-volatile int index = 0;
-volatile bool inc_flag = false;
-
-// Increments the counter and write new value to display
-void incrementCounter() {
+#endif
+int index = 0;
+
+// Buttons pressed, set by the interrupts and acted on in loop() so frames are only written
+// from one place
+#define PRESS_DOWN      0x01
+#define PRESS_UP        0x02
+#define PRESS_COUNT     0x04
+#define PRESS_POWER     0x08
+volatile uint8_t pressed = 0;
+
+// Calibration values received by the c command
+int cal[SYMBOL_COUNT];
+
+// Free RAM between the heap and the stack is painted by setup, the m command finds the lowest
+// byte the stack has overwritten since
+#define STACK_PAINT 0xA5
+#if defined(__AVR__)
+extern uint8_t __heap_start;
+extern char *__brkval;
+
+uint8_t *stackFloor() {
+    return __brkval ? (uint8_t *)__brkval : &__heap_start;
+}
 
-    // Check if increment function is already running
-    if (inc_flag) {
-        return;
+void stackPaint() {
+    for (uint8_t *p = stackFloor(); p < (uint8_t *)SP; p++) {
+        *p = STACK_PAINT;
     }
+}
+#endif
 
-    // Set inc_flag
-    inc_flag = true;
+// Increments the counter and write new value to display
+void incrementCounter() {
 
     // Reset frame buffer
     dataVu.updateFrame(0);
 
-    // Calculate digits
-    int D1 = counter % 10;
-    int D2 = (counter / 10) % 10;
-    int D3 = (counter / 100) % 10;
-    int D4 = counter / 1000;
-
-    // Write digits to frame buffer
-    dataVu.updateDigit(D1, 0, values[index]);
-    dataVu.updateDigit(D2, 1, values[index]);
-    dataVu.updateDigit(D3, 2, values[index]);
-    dataVu.updateDigit(D4, 3, values[index]);
+    // Write counter to frame buffer
+    dataVu.displayNumber(counter, 0, NUMBER_RIGHT, values[index]);
 
     // Write frame buffer to PWM chips
     dataVu.writeFrame();
@@ -95,9 +122,6 @@ void incrementCounter() {
     else {
         counter++;
     }
-
-    // Unset inc_flag
-    inc_flag = false;
 }
 
 // Pin change interrupt function - For BTN1,2,3
@@ -111,25 +135,17 @@ ISR(PCINT0_vect) {
 
         // Decrease brightness
         if (PINB & _BV(PB0)) {
-            if (index != 0) {
-                index--;
-                dataVu.updateFrame(values[index]);
-                dataVu.writeFrame();
-            }
+            pressed |= PRESS_DOWN;
         }
 
         // Increase brightness
         else if (PINB & _BV(PB2)) {
-            if (index != (VALUE_COUNT - 1)) {
-                index++;
-                dataVu.updateFrame(values[index]);
-                dataVu.writeFrame();
-            }
+            pressed |= PRESS_UP;
         }
 
         // Increment counter
         else if (PINB & _BV(PB7)) {
-            incrementCounter();
+            pressed |= PRESS_COUNT;
         }
     }
     lastTime = currTime;
@@ -143,46 +159,86 @@ void power() {
 
     // Check if debounce time has elapsed since last interrupt
     if ((currTime - lastTime) > DEBOUNCE_TIME) {
+        pressed |= PRESS_POWER;
+    }
+    lastTime = currTime;
+}
+
+// Acts on the buttons pressed since the last call
+void buttonPoll() {
+    uint8_t sreg = SREG;
+    cli();
+    uint8_t buttons = pressed;
+    pressed = 0;
+    SREG = sreg;
+
+    // Decrease brightness
+    if ((buttons & PRESS_DOWN) && index != 0) {
+        index--;
+        dataVu.updateFrame(values[index]);
+        dataVu.writeFrame();
+    }
+
+    // Increase brightness
+    if ((buttons & PRESS_UP) && index != (VALUE_COUNT - 1)) {
+        index++;
+        dataVu.updateFrame(values[index]);
+        dataVu.writeFrame();
+    }
 
-        // Turn display off
+    // Increment counter
+    if (buttons & PRESS_COUNT) {
+        incrementCounter();
+    }
+
+    // Turn display off, or on and reset variables
+    if (buttons & PRESS_POWER) {
         if (state) {
             dataVu.setVoltage(0);
             state = false;
         }
-
-        // Turn display on and reset variables
         else {
-              counter = 0;
-              index = 0;
-              dataVu.updateFrame(values[index]);
-              dataVu.writeFrame();
-              dataVu.setVoltage(VOLTAGE);
-              state = true;
+            counter = 0;
+            index = 0;
+            dataVu.updateFrame(values[index]);
+            dataVu.writeFrame();
+            dataVu.setVoltage(VOLTAGE);
+            state = true;
         }
     }
-    lastTime = currTime;
 }
 
+// CLI command table, sorted by name
+constexpr cmd_t CMD_TABLE[] PROGMEM = {
+    {"b",       cli_b},
+    {"c",       cli_c,      cli_c_arg},
+    {"cOff",    cli_cOff},
+    {"cOn",     cli_cOn},
+    {"cn",      cli_cn},
+    {"cp",      cli_cp},
+    {"d",       cli_d},
+    {"h",       cli_help},
+    {"help",    cli_help},
+    {"m",       cli_m},
+    {"r",       cli_r},
+    {"s",       cli_s},
+    {"sc",      cli_sc},
+    {"u",       cli_u,      cli_u_arg},
+    {"ua",      cli_ua},
+    {"ud",      cli_ud},
+    {"us",      cli_us},
+    {"v",       cli_v},
+    {"w",       cli_w}
+};
+static_assert(cmdSorted(CMD_TABLE, CMD_COUNT(CMD_TABLE)), "CMD_TABLE must be sorted by name");
+
 void setup() {
 
     // Initialize dataVu object
     dataVu.begin();
 
     // Initialize UART CLI
-    cmdInit(9600);
-
-    // Add commands to CLI
-    cmdAdd("help", cli_help);
-    cmdAdd("h", cli_help);
-    cmdAdd("v", cli_v);
-    cmdAdd("ua", cli_ua);
-    cmdAdd("us", cli_us);
-    cmdAdd("u", cli_u);
-    cmdAdd("ud", cli_ud);
-    cmdAdd("w", cli_w);
-    cmdAdd("cOn", cli_cOn);
-    cmdAdd("cOff", cli_cOff);
-    cmdAdd("c", cli_c);
+    cmdInit(9600, CMD_TABLE, CMD_COUNT(CMD_TABLE));
 
     // Setup pin change interrupts
     cli();
@@ -194,11 +250,21 @@ void setup() {
 
     // Attach external interrupt
     attachInterrupt(digitalPinToInterrupt(PD2), power, RISING);
+
+#if defined(__AVR__)
+    stackPaint();
+#endif
 }
 
 void loop() {
-    // CLI loop
-    cmdPoll();
+    // CLI loop, or binary frame protocol once entered with the b command
+    if (binActive()) {
+        binPoll();
+    }
+    else {
+        cmdPoll();
+    }
+    buttonPoll();
 
     // Check for button hold condition
     if (PINB & _BV(PB7)) {
@@ -242,8 +308,8 @@ int cli_v(int arg_cnt, char **args){
 int cli_ua(int arg_cnt, char **args){
 
     // Check value range
-    int value = atoi(args[1])*16;
-    if (value < 0 || value > 4095) {
+    int value = atoi(args[1]) * DATAVU_VALUE_SCALE;
+    if (value < 0 || value > DATAVU_VALUE_MAX) {
         return 1;
     }
 
@@ -259,11 +325,11 @@ int cli_us(int arg_cnt, char **args){
 
     // Check symbol and value range
     int symbol = atoi(args[1]);
-    int value = atoi(args[2])*16;
+    int value = atoi(args[2]) * DATAVU_VALUE_SCALE;
     if (symbol < 0 || symbol >= SYMBOL_COUNT) {
         return 1;
     }
-    else if (value < 0 || value > 4095) {
+    else if (value < 0 || value > DATAVU_VALUE_MAX) {
         return 1;
     }
 
@@ -277,23 +343,23 @@ int cli_us(int arg_cnt, char **args){
 // Sets every symbol's PWM duty cycle with a unique value
 int cli_u(int arg_cnt, char **args){
 
-    // Check number of arguments
+    // Values are written by cli_u_arg as they arrive, check number of arguments
     if (arg_cnt != SYMBOL_COUNT + 1) {
         return 1;
     }
+    return 0;
+}
 
-    // Loop over arguments  
-    for (int i=0; i < SYMBOL_COUNT; i++) {
-        int value = atoi(args[i+1]) * 16;
-
-        // Check values are in range
-        if (value < 0 || value > 4095) {
-          return 1;
-        }
+// Writes one value of the u command to the frame buffer
+int cli_u_arg(uint8_t i, uint16_t value){
 
-        // Update frame buffer
-        dataVu.frameBuf[i] = value;
+    // Check index and value are in range
+    if (i >= SYMBOL_COUNT || value > 255) {
+        return 1;
     }
+
+    // Update frame buffer
+    dataVu.updateSymbol(i, value * DATAVU_VALUE_SCALE);
     return 0;
 }
 
@@ -314,11 +380,11 @@ int cli_ud(int arg_cnt, char **args){
 
     // Check symbol number and value are in range
     int digit = atoi(args[2]);
-    int value = atof(args[3]) * 16;
+    int value = atof(args[3]) * DATAVU_VALUE_SCALE;
     if (digit < 0 || digit >= DIGIT_COUNT) {
         return 1;
     }
-    else if (value < 0 || value > 4095) {
+    else if (value < 0 || value > DATAVU_VALUE_MAX) {
         return 1;
     }
 
@@ -351,29 +417,175 @@ int cli_cOff(int arg_cnt, char **args){
 // Sets the calibration values 
 int cli_c(int arg_cnt, char **args){
 
-    // Check number of arguments
+    // Values are stored by cli_c_arg as they arrive, check number of arguments
     if (arg_cnt != SYMBOL_COUNT + 1) {
         return 1;
-  }
+    }
 
-    // Create cal array
-    int cal[SYMBOL_COUNT];
+    // Update calibration
+    dataVu.writeCal(cal, true);
+    
+    return 0;
+}
 
-    // Loop over arguments  
-    for (int i=0; i < SYMBOL_COUNT; i++) {
-    int calTemp = atoi(args[i+1]);
+// Stores one value of the c command in the cal array
+int cli_c_arg(uint8_t i, uint16_t calTemp){
 
-        // Check values are in range
-        if (calTemp < 0 || calTemp > 63) {
-            return 1;
-        }
-        else {
-            cal[i] = calTemp;
-        }
+    // Check index and value are in range
+    if (i >= SYMBOL_COUNT || calTemp > 63) {
+        return 1;
     }
+    cal[i] = calTemp;
+    return 0;
+}
 
-    // Update calibration
-    dataVu.writeCal(cal, true);
+// Loads a calibration profile from EEPROM
+int cli_cp(int arg_cnt, char **args){
+
+    // Check number of arguments
+    if (arg_cnt != 2) {
+        return 1;
+    }
+    return dataVu.loadCal(atoi(args[1])) ? 1 : 0;
+}
+
+// Names the loaded calibration profile
+int cli_cn(int arg_cnt, char **args){
+
+    // Check number of arguments and that the profile has been saved
+    if (arg_cnt != 2 || dataVu.readCal(cal, dataVu.getCalProfile())) {
+        return 1;
+    }
+    return dataVu.saveCal(cal, dataVu.getCalProfile(), args[1]) ? 1 : 0;
+}
+
+// Saves the frame buffer and voltage as the splash frame
+int cli_s(int arg_cnt, char **args){
+    dataVu.saveSplash();
+    return 0;
+}
+
+// Clears the splash frame
+int cli_sc(int arg_cnt, char **args){
+    dataVu.clearSplash();
+    return 0;
+}
+
+// Runs the LED driver self test and prints the faults found
+int cli_d(int arg_cnt, char **args){
+    uint8_t open[SYMBOL_MASK_SIZE];
+    int faults = dataVu.diagnostics(open);
+    if (faults & DIAG_NO_SDO) {
+        return 1;
+    }
     
+    // Over temperature, then the symbols with an open LED
+    Serial.println();
+    Serial.print("Over temperature: ");
+    Serial.println(faults & DIAG_OVER_TEMP ? "yes" : "no");
+    Serial.print("Open LEDs:");
+    for (int i = 0; i < SYMBOL_COUNT; i++) {
+        if (open[i >> 3] & (1 << (i & 7))) {
+            Serial.print(' ');
+            Serial.print(i);
+        }
+    }
+    Serial.println();
+    Serial.print("Verify errors: ");
+    Serial.print(dataVu.getVerifyErrors());
+    return 0;
+}
+
+// Sets the PWM refresh rate and prints the rate the PCLK divider gives
+int cli_r(int arg_cnt, char **args){
+
+    // Check number of arguments
+    if (arg_cnt != 2) {
+        return 1;
+    }
+    float rate = dataVu.setRefreshRate(atof(args[1]));
+    if (rate == 0) {
+        return 1;
+    }
+    Serial.println();
+    Serial.print("Refresh rate: ");
+    Serial.print(rate);
+    Serial.print("Hz");
+    return 0;
+}
+
+// Prints the stack high-water mark and the RAM left below it
+int cli_m(int arg_cnt, char **args){
+#if defined(__AVR__)
+    uint8_t *bottom = stackFloor();
+    uint8_t *low = bottom;
+    while (low < (uint8_t *)SP && *low == STACK_PAINT) {
+        low++;
+    }
+    Serial.println();
+    Serial.print("Stack used: ");
+    Serial.print((unsigned int)((uint8_t *)RAMEND - low + 1));
+    Serial.println(" bytes");
+    Serial.print("Never reached: ");
+    Serial.print((unsigned int)(low - bottom));
+    Serial.print(" bytes");
+    return 0;
+#else
+    // Only the ATMega has a stack to measure
+    return 1;
+#endif
+}
+
+// Enters binary frame mode
+int cli_b(int arg_cnt, char **args){
+    binBegin(bin_frame);
     return 0;
-}
\ No newline at end of file
+}
+
+// Applies a binary frame mode packet
+int bin_frame(uint8_t type, uint8_t *data, uint8_t len){
+
+    switch (type & ~BIN_LATCH) {
+
+        // Eight bit values, scaled as the u command
+        case BIN_FRAME8:
+            if (len != SYMBOL_COUNT) {
+                return BIN_ERR_LENGTH;
+            }
+            for (int i = 0; i < SYMBOL_COUNT; i++) {
+                dataVu.updateSymbol(i, data[i] * DATAVU_VALUE_SCALE);
+            }
+            break;
+
+        // Twelve bit values, MSB first. The frame buffer holds eight bit values with a gamma curve.
+        case BIN_FRAME12:
+            if (DATAVU_GAMMA) {
+                return BIN_ERR_TYPE;
+            }
+            if (len != FRAME12_SIZE) {
+                return BIN_ERR_LENGTH;
+            }
+            for (int i = 0; i < SYMBOL_COUNT; i++) {
+                uint8_t *p = data + i * 3 / 2;
+                if (i & 1) {
+                    dataVu.updateSymbol(i, ((p[0] & 0x0F) << 8) | p[1]);
+                }
+                else {
+                    dataVu.updateSymbol(i, (p[0] << 4) | (p[1] >> 4));
+                }
+            }
+            break;
+
+        case BIN_WRITE:
+            break;
+
+        default:
+            return BIN_ERR_TYPE;
+    }
+
+    // Write frame buffer to PWM chips
+    if ((type & BIN_LATCH) || type == BIN_WRITE) {
+        dataVu.writeFrame();
+    }
+    return BIN_OK;
+}
@@ -0,0 +1,67 @@
+/******************************************************************************
+    This file is a benchmark of the cross-fade engine of the Data-Vu evaluation
+    kit library created by Plessey Semiconductors.
+
+    Copyright (C) 2019  <Gethn Pickard>
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <https://www.gnu.org/licenses/>.
+******************************************************************************/
+
+/*
+    Prints the time one fade frame takes for the selected board, with and
+    without an easing curve. The frame write is included, so set DATAVU_ASYNC
+    to 1 in dataVuConfig.h to time only the fade itself.
+*/
+
+#include <dataVuLib.h>
+#include <dataVuFade.h>
+
+#define BENCH_TICKS 100
+
+// Create dataVu and fade objects
+DataVu dataVu;
+DataVuFade fade(dataVu);
+
+// Average microseconds per frame over BENCH_TICKS frames
+unsigned long benchFade(uint8_t curve) {
+
+    // Long fade with a frame every tick so every call renders
+    dataVu.updateFrame(0);
+    fade.fadeAllTo(4095, 60000, curve, 1);
+    fade.stop();
+
+    unsigned long start = micros();
+    for (int i = 0; i < BENCH_TICKS; i++) {
+        fade.tick();
+    }
+    return (micros() - start) / BENCH_TICKS;
+}
+
+void setup() {
+
+    // Initialize object
+    dataVu.begin();
+    Serial.begin(9600);
+
+    Serial.println(DISPLAY_TYPE);
+    Serial.print("Symbols: ");
+    Serial.println(SYMBOL_COUNT);
+    Serial.print("Linear frame (us): ");
+    Serial.println(benchFade(FADE_LINEAR));
+    Serial.print("Eased frame (us): ");
+    Serial.println(benchFade(FADE_EASE_IN_OUT));
+}
+
+void loop() {
+}
@@ -0,0 +1,48 @@
+/******************************************************************************
+    This file is an example for the Data-Vu evaluation kit library created by
+    Plessey Semiconductors. It drives a second display from the same ATMega.
+    
+    Copyright (C) 2019  <Gethn Pickard>
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <https://www.gnu.org/licenses/>.
+******************************************************************************/
+
+#include <dataVuLib.h>
+
+// Second LT8500 chain wired to A0 (SDI), A1 (SCKI) and A2 (LATCH). PCLK is shared.
+DATAVU_PINS(PanelPins, PORTC, DDRC, 0, 1, 2);
+
+// Display on the driver board and the second display
+DataVu dataVu;
+DataVuChain<PanelPins> panel;
+
+void setup() {
+
+    // Initialize both displays
+    dataVu.begin();
+    panel.begin();
+    dataVu.setVoltage(2.7);
+}
+
+void loop() {
+
+    // Ramp one display up while the other ramps down
+    for (int i = 0; i < 256; i++) {
+        dataVu.updateFrame(i * DATAVU_VALUE_SCALE);
+        panel.updateFrame((255 - i) * DATAVU_VALUE_SCALE);
+        dataVu.writeFrame();
+        panel.writeFrame();
+        delay(10);
+    }
+}
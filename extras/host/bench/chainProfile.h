@@ -0,0 +1,73 @@
+/******************************************************************************
+    This file is a display profile for the chip count benchmarks of the host
+    build of the Data-Vu evaluation kit library created by Plessey
+    Semiconductors.
+
+    Copyright (C) 2019  <Gethn Pickard>
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <https://www.gnu.org/licenses/>.
+******************************************************************************/
+
+/*
+    A panel of LT8500_COUNT chips (1 to 8) with 40 symbols on each chip and the last eight
+    channels unused, like the Data-Vu board. Used with -DDATAVU_PROFILE='"chainProfile.h"'.
+*/
+
+#ifndef CHAIN_PROFILE_H
+#define CHAIN_PROFILE_H
+
+#if LT8500_COUNT < 1 || LT8500_COUNT > 8
+#error "chainProfile.h has one to eight chips"
+#endif
+
+#define DISPLAY_TYPE "Chain"
+#define SYMBOL_COUNT (LT8500_COUNT * 40)
+#define DIGIT_COUNT 0
+
+#if SYMBOL_COUNT > 127 && !DATAVU_WIDE_SYMBOLS
+#error "chainProfile.h needs DATAVU_WIDE_SYMBOLS for more than three chips"
+#endif
+
+// Symbol of channel i of chip c
+#define CHAIN_SYMBOL(c, i)  ((i) < 40 ? (c) * 40 + (i) : -1)
+#define CHAIN4(c, i)        CHAIN_SYMBOL(c, i), CHAIN_SYMBOL(c, i + 1), CHAIN_SYMBOL(c, i + 2), CHAIN_SYMBOL(c, i + 3)
+#define CHAIN_CHIP(c)       CHAIN4(c, 0), CHAIN4(c, 4), CHAIN4(c, 8), CHAIN4(c, 12), CHAIN4(c, 16), CHAIN4(c, 20), \
+                            CHAIN4(c, 24), CHAIN4(c, 28), CHAIN4(c, 32), CHAIN4(c, 36), CHAIN4(c, 40), CHAIN4(c, 44)
+
+const symbol_t SYMBOL_MAP[PWM_CHANNEL_COUNT] PROGMEM = {
+    CHAIN_CHIP(0),
+#if LT8500_COUNT > 1
+    CHAIN_CHIP(1),
+#endif
+#if LT8500_COUNT > 2
+    CHAIN_CHIP(2),
+#endif
+#if LT8500_COUNT > 3
+    CHAIN_CHIP(3),
+#endif
+#if LT8500_COUNT > 4
+    CHAIN_CHIP(4),
+#endif
+#if LT8500_COUNT > 5
+    CHAIN_CHIP(5),
+#endif
+#if LT8500_COUNT > 6
+    CHAIN_CHIP(6),
+#endif
+#if LT8500_COUNT > 7
+    CHAIN_CHIP(7),
+#endif
+};
+
+#endif //CHAIN_PROFILE_H
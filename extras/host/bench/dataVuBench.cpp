@@ -0,0 +1,982 @@
+/******************************************************************************
+    This file is the benchmark suite of the host build of the Data-Vu
+    evaluation kit library created by Plessey Semiconductors.
+
+    Copyright (C) 2019  <Gethn Pickard>
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <https://www.gnu.org/licenses/>.
+******************************************************************************/
+
+/*
+    Benchmarks of the library API against the LT8500 model. Each benchmark is timed on the
+    host and also reports, per call:
+
+        port_writes     PORTD writes, one cycle each in the AVR serialization kernel
+        bits            SCKI edges seen by the model
+        latches         Commands latched by the model
+
+    The time from the start of begin to the first latch that lights an LED, with a splash
+    frame saved, is reported on the virtual clock. So is the flash taken by the symbol maps,
+    which are fixed width and the same size on the AVR.
+
+    The layout and options follow Google Benchmark:
+
+        dataVuBench [--filter=<regex>] [--format=console|json] [--min_time=<seconds>]
+
+    Before timing anything the model is used to check that begin, writeFrame and writeCal
+    leave the chips with the expected registers. The exit code is 1 if a check fails.
+*/
+
+#include <algorithm>
+#include <chrono>
+#include <map>
+#include <regex>
+#include <string>
+#include <vector>
+#include <stdio.h>
+#include <string.h>
+
+#include "dataVuLib.h"
+#include "dataVuAnim.h"
+#include "dataVuFade.h"
+#include "dataVuHost.h"
+#include "lt8500Model.h"
+
+/*
+    Counts writes to a port
+*/
+class WriteCounter : public HostPortListener
+{
+    public:
+        unsigned long writes;
+        WriteCounter() : writes(0) {}
+        void portWrite(uint8_t) { this->writes++; }
+};
+
+/*
+    Loop state of one benchmark run
+*/
+class State
+{
+    public:
+        DataVu &dataVu;
+        unsigned long iterations;
+        unsigned long index;
+
+        State(DataVu &dataVu, unsigned long iterations) : dataVu(dataVu), iterations(iterations), index(0) {}
+        bool next() { return this->index++ < this->iterations; }
+};
+
+struct Benchmark
+{
+    const char *name;
+    void (*run)(State &);
+};
+
+struct Result
+{
+    std::string name;
+    unsigned long iterations;
+    double ns;
+    double portWrites;
+    double bits;
+    double latches;
+};
+
+static LT8500Chain *model;
+static WriteCounter counter;
+
+/////////////////////////////////////////BENCHMARKS////////////////////////////////////////////
+
+static void BM_writeFrame(State &state) {
+    while (state.next()) {
+        state.dataVu.writeFrame(true);
+    }
+}
+
+static void BM_writeFrameSkipped(State &state) {
+    state.dataVu.writeFrame();
+    while (state.next()) {
+        state.dataVu.writeFrame();
+    }
+}
+
+static void BM_writeFrameDirty(State &state) {
+    while (state.next()) {
+        state.dataVu.updateSymbol(state.index % SYMBOL_COUNT, state.index % DATAVU_VALUE_MAX);
+        state.dataVu.writeFrame();
+    }
+}
+
+static void BM_updateFrame(State &state) {
+    while (state.next()) {
+        state.dataVu.updateFrame(state.index % DATAVU_VALUE_MAX);
+    }
+}
+
+static void BM_updateSymbol(State &state) {
+    while (state.next()) {
+        state.dataVu.updateSymbol(state.index % SYMBOL_COUNT, state.index % DATAVU_VALUE_MAX);
+    }
+}
+
+// Frames for the bulk loads, alternated so no load is skipped
+static uint16_t loadFrames[2][SYMBOL_COUNT];
+static const uint16_t LOAD_FRAME_P[SYMBOL_COUNT] PROGMEM = {DATAVU_VALUE_MAX};
+
+static void BM_loadFrame(State &state) {
+    for (int i = 0; i < SYMBOL_COUNT; i++) {
+        loadFrames[0][i] = i % (DATAVU_VALUE_MAX + 1);
+        loadFrames[1][i] = DATAVU_VALUE_MAX - loadFrames[0][i];
+    }
+    while (state.next()) {
+        state.dataVu.loadFrame(loadFrames[state.index & 1]);
+    }
+}
+
+static void BM_loadFrame_P(State &state) {
+    while (state.next()) {
+        state.dataVu.loadFrame_P(LOAD_FRAME_P);
+    }
+}
+
+static void BM_fillRange(State &state) {
+    while (state.next()) {
+        state.dataVu.fillRange(0, SYMBOL_COUNT / 2, state.index % DATAVU_VALUE_MAX);
+    }
+}
+
+static void BM_updateMasked(State &state) {
+    uint8_t mask[SYMBOL_MASK_SIZE];
+    for (int i = 0; i < SYMBOL_MASK_SIZE; i++) {
+        mask[i] = 0x55;
+    }
+    while (state.next()) {
+        state.dataVu.updateMasked(mask, state.index % DATAVU_VALUE_MAX);
+    }
+}
+
+#if DIGIT_COUNT > 0
+static void BM_updateDigit(State &state) {
+    while (state.next()) {
+        state.dataVu.updateDigit(state.index % 10, state.index % DIGIT_COUNT, DATAVU_VALUE_MAX);
+    }
+}
+
+// Every digit of a number, the way the example sketches did it before displayNumber
+static void BM_updateDigits(State &state) {
+    while (state.next()) {
+        unsigned long n = state.index;
+        for (int digit = 0; digit < DIGIT_COUNT; digit++) {
+            state.dataVu.updateDigit(n % 10, digit, DATAVU_VALUE_MAX);
+            n /= 10;
+        }
+    }
+}
+
+static void BM_displayNumber(State &state) {
+    while (state.next()) {
+        state.dataVu.displayNumber(state.index % 1000000 - 99999);
+    }
+}
+
+// Numbers that fill every digit, none blanked
+static void BM_displayNumberFull(State &state) {
+    long low = 1;
+    for (int digit = 1; digit < DIGIT_COUNT; digit++) {
+        low *= 10;
+    }
+    while (state.next()) {
+        state.dataVu.displayNumber(low + state.index % (9 * low));
+    }
+}
+
+static void BM_displayHex(State &state) {
+    while (state.next()) {
+        state.dataVu.displayHex(state.index & 0xFFFFFF);
+    }
+}
+#endif
+
+// One frame period of a fade per tick, rendered and written
+static void BM_fadeTick(State &state) {
+    DataVuFade fade(state.dataVu);
+    while (state.next()) {
+        if (not fade.running()) {
+            fade.fadeAllTo(state.dataVu.getSymbol(0) ? 0 : DATAVU_VALUE_MAX, 255, FADE_EASE_IN_OUT, 1);
+        }
+        fade.tick();
+    }
+}
+
+static void BM_writeCal(State &state) {
+    // Alternate two sets so every write misses the correction shadow
+    int cal[2][SYMBOL_COUNT];
+    for (int i = 0; i < SYMBOL_COUNT; i++) {
+        cal[0][i] = i % 64;
+        cal[1][i] = 63 - i % 64;
+    }
+    while (state.next()) {
+        state.dataVu.writeCal(cal[state.index & 1]);
+    }
+}
+
+static void BM_writeCalSkipped(State &state) {
+    int cal[SYMBOL_COUNT];
+    for (int i = 0; i < SYMBOL_COUNT; i++) {
+        cal[i] = i % 64;
+    }
+    state.dataVu.writeCal(cal);
+    while (state.next()) {
+        state.dataVu.writeCal(cal);
+    }
+}
+
+static void BM_begin(State &state) {
+    while (state.next()) {
+        state.dataVu.begin();
+    }
+}
+
+static const Benchmark BENCHMARKS[] = {
+    {"BM_writeFrame", BM_writeFrame},
+    {"BM_writeFrameSkipped", BM_writeFrameSkipped},
+    {"BM_writeFrameDirty", BM_writeFrameDirty},
+    {"BM_updateFrame", BM_updateFrame},
+    {"BM_updateSymbol", BM_updateSymbol},
+    {"BM_loadFrame", BM_loadFrame},
+    {"BM_loadFrame_P", BM_loadFrame_P},
+    {"BM_fillRange", BM_fillRange},
+    {"BM_updateMasked", BM_updateMasked},
+#if DIGIT_COUNT > 0
+    {"BM_updateDigit", BM_updateDigit},
+    {"BM_updateDigits", BM_updateDigits},
+    {"BM_displayNumber", BM_displayNumber},
+    {"BM_displayNumberFull", BM_displayNumberFull},
+    {"BM_displayHex", BM_displayHex},
+#endif
+    {"BM_fadeTick", BM_fadeTick},
+    {"BM_writeCal", BM_writeCal},
+    {"BM_writeCalSkipped", BM_writeCalSkipped},
+    {"BM_begin", BM_begin},
+};
+
+///////////////////////////////////////////CHECKS//////////////////////////////////////////////
+
+static int failures;
+
+static void check(bool ok, const char *what) {
+    if (not ok) {
+        fprintf(stderr, "model check failed: %s\n", what);
+        failures++;
+    }
+}
+
+/**
+    Check the model holds the frame buffer, when frame values are PWM values
+*/
+static void checkFrame(DataVu &dataVu) {
+#if DATAVU_GAMMA == DATAVU_GAMMA_NONE
+    if (dataVu.getMasterBrightness() != 255) {
+        return;
+    }
+    bool ok = true;
+    for (int i = 0; i < PWM_CHANNEL_COUNT; i++) {
+        int16_t symbol = readSymbol(&SYMBOL_MAP[i]);
+        uint16_t expected = symbol < 0 ? 0 : dataVu.getSymbol(symbol);
+        ok = ok && model->pwm(i) == expected;
+    }
+    check(ok, "PWM registers do not match the frame buffer");
+#else
+    (void)dataVu;
+#endif
+}
+
+#if DIGIT_COUNT > 0
+/**
+    Check the digits show the characters in text, the first character on the last digit
+*/
+static bool checkDigits(DataVu &dataVu, const char *text) {
+    for (int digit = 0; digit < DIGIT_COUNT; digit++) {
+        uint8_t bitmap = pgm_read_byte(&CHARACTERARRAY[(uint8_t)text[DIGIT_COUNT - 1 - digit]]);
+        for (int i = 0; i < 7; i++) {
+            int16_t symbol = readSymbol(&SEVSEG_MAP[digit][6 - i]);
+            if ((dataVu.getSymbol(symbol) != 0) != ((bitmap >> i) & 1)) {
+                return false;
+            }
+        }
+    }
+    return true;
+}
+#endif
+
+/**
+    Check the correction registers hold cal
+*/
+static bool correctionIs(const int *cal) {
+    for (int i = 0; i < PWM_CHANNEL_COUNT; i++) {
+        int16_t symbol = readSymbol(&SYMBOL_MAP[i]);
+        if (model->correction(i) != (symbol < 0 ? 0 : cal[symbol])) {
+            return false;
+        }
+    }
+    return true;
+}
+
+/**
+    Calibration profiles and corrupt records
+*/
+static void checkCalStore(DataVu &dataVu) {
+
+    static int a[SYMBOL_COUNT], b[SYMBOL_COUNT], out[SYMBOL_COUNT];
+    for (int i = 0; i < SYMBOL_COUNT; i++) {
+        a[i] = (i * 7) % 64;
+        b[i] = 63 - a[i];
+    }
+    uint8_t last = CAL_PROFILE_COUNT - 1;
+    char name[CAL_NAME_SIZE + 1];
+
+    // Blank EEPROM has no records and begin leaves the correction registers alone
+    memset(EEPROM.mem, 0xFF, sizeof(EEPROM.mem));
+    check(dataVu.readCal(out, 0) == 2, "readCal found a record in a blank EEPROM");
+
+    // Bad input is not saved
+    memcpy(out, a, sizeof(a));
+    out[0] = 64;
+    check(dataVu.saveCal(out, 0) == 1 && dataVu.saveCal(a, CAL_PROFILE_COUNT) == 2 && dataVu.readCal(out, 0) == 2,
+        "saveCal accepted bad input");
+
+    // Saved profiles read back with their names
+    check(dataVu.saveCal(a, last, "warm") == 0, "saveCal failed");
+    check(dataVu.readCal(out, last, name) == 0 && memcmp(out, a, sizeof(a)) == 0 && strcmp(name, "warm") == 0,
+        "readCal did not return the saved profile");
+    check(dataVu.findCal("warm") == last && dataVu.findCal("cold") == -1, "findCal");
+
+    // Switching profile at runtime loads the chips
+    check(dataVu.loadCal(last) == 0 && correctionIs(a) && dataVu.getCalProfile() == last, "loadCal");
+
+    // A newer record is used, and the older one again once the newer is corrupt
+    check(dataVu.writeCal(b, true) == 0, "writeCal(save) failed");
+    check(dataVu.readCal(out, last, name) == 0 && memcmp(out, b, sizeof(b)) == 0 && strcmp(name, "warm") == 0,
+        "writeCal did not save to the loaded profile");
+#if CAL_SLOT_COUNT > 1
+    int addr = CALIBRATION_ADDR + (last * CAL_SLOT_COUNT + 1) * CAL_RECORD_SIZE;
+    EEPROM.mem[addr + CAL_HEADER_SIZE + CAL_NAME_SIZE] ^= 0x10;
+    check(dataVu.readCal(out, last) == 0 && memcmp(out, a, sizeof(a)) == 0, "corrupt record was not skipped");
+#endif
+
+    // Later checks start from a blank EEPROM
+    memset(EEPROM.mem, 0xFF, sizeof(EEPROM.mem));
+}
+
+// Virtual time from the start of begin to the first latch that lit an LED, with a splash frame
+static double bootLightUs;
+
+/**
+    Splash frame shown by begin and the time it takes to appear
+*/
+static void checkSplash(DataVu &dataVu) {
+
+    for (int i = 0; i < SYMBOL_COUNT; i++) {
+        dataVu.updateSymbol(i, (i * 37 + 1) % 256 * DATAVU_VALUE_SCALE);
+    }
+    dataVu.setVoltage(3.0);
+    uint8_t dac = OCR1A;
+    dataVu.saveSplash();
+
+    // Shown by the latch that enables the outputs
+    DataVu fresh;
+    model->clearStats();
+    uint64_t start = hostCycles();
+    fresh.begin();
+    check(model->firstLightCycle != 0 && OCR1A == dac, "begin did not show the splash frame");
+    bootLightUs = (model->firstLightCycle - start) * 1e6 / F_CPU;
+    bool ok = true;
+    for (int i = 0; i < SYMBOL_COUNT; i++) {
+        ok = ok && fresh.getSymbol(i) == dataVu.getSymbol(i);
+    }
+    check(ok, "splash frame did not load into the frame buffer");
+    checkFrame(fresh);
+
+    // A corrupt or cleared splash frame starts dark
+    EEPROM.mem[SPLASH_ADDR + 3] ^= 0x01;
+    fresh.begin();
+    check(fresh.getSymbol(1) == 0 && OCR1A == 0, "corrupt splash frame was shown");
+    dataVu.saveSplash();
+    dataVu.clearSplash();
+    fresh.begin();
+    check(fresh.getSymbol(1) == 0, "cleared splash frame was shown");
+    dataVu.begin();
+}
+
+/**
+    Status frames read back by diagnostics and frames corrupted on the way to the chips
+*/
+static void checkReadback(DataVu &dataVu) {
+
+    // Open LED of a symbol and an over temperature chip
+    int channel = 0;
+    while (readSymbol(&SYMBOL_MAP[channel]) != 3) {
+        channel++;
+    }
+    uint8_t open[SYMBOL_MASK_SIZE];
+    check(dataVu.diagnostics(open) == 0 && open[0] == 0, "diagnostics found a fault on healthy chips");
+    model->setLedOpen(channel, true);
+    model->setOverTemp(model->chipCount() - 1, true);
+    check(dataVu.diagnostics(open) == (DIAG_OPEN_LED | DIAG_OVER_TEMP) && open[0] == 1 << 3,
+        "diagnostics did not find the faults");
+    model->setLedOpen(channel, false);
+    model->setOverTemp(model->chipCount() - 1, false);
+    check(dataVu.diagnostics() == 0, "diagnostics kept a cleared fault");
+
+    // The chips keep their frame
+    dataVu.writeFrame(true);
+    checkFrame(dataVu);
+
+#if DATAVU_VERIFY
+    // A glitch in the first pass is caught and the frame sent again
+    unsigned long errors = dataVu.getVerifyErrors();
+    model->clearStats();
+    model->glitchBit = 10;
+    dataVu.updateSymbol(0, DATAVU_VALUE_MAX);
+    dataVu.writeFrame();
+    check(dataVu.getVerifyErrors() == errors + 1 && model->latches == 1, "corrupt frame was not sent again");
+    checkFrame(dataVu);
+#endif
+}
+
+/**
+    Check every chip has a configuration, as CHIP_* flags
+*/
+static bool configIs(uint8_t config) {
+    for (int n = 0; n < model->chipCount(); n++) {
+        const LT8500 &c = model->chip(n);
+        uint8_t actual = (c.correctionEnabled ? CHIP_CORRECTION : 0) | (c.phaseShift ? CHIP_PHASE_SHIFT : 0) |
+            (c.outputEnabled ? CHIP_OUTPUTS : 0);
+        if (actual != config) {
+            return false;
+        }
+    }
+    return true;
+}
+
+/**
+    Commands are only sent for changes and resync recovers chips that missed one
+*/
+static void checkShadow(DataVu &dataVu) {
+
+    static int a[SYMBOL_COUNT];
+    for (int i = 0; i < SYMBOL_COUNT; i++) {
+        a[i] = (i * 11) % 64;
+    }
+    dataVu.writeCal(a);
+    dataVu.setCal(true);
+    check(configIs(CHIP_DEFAULT_CONFIG | CHIP_CORRECTION) && dataVu.getConfig() == (CHIP_DEFAULT_CONFIG | CHIP_CORRECTION),
+        "setCal(true) configuration");
+
+    // Asking for the state the chips are in sends nothing
+    model->clearStats();
+    dataVu.setCal(true);
+    dataVu.setPhaseShift(true);
+    dataVu.setOutputs(true);
+    dataVu.writeCal(a);
+    check(model->latches == 0, "unchanged configuration or calibration was sent again");
+
+    // Explicit setters
+    dataVu.setOutputs(false);
+    dataVu.setPhaseShift(false);
+    check(configIs(CHIP_CORRECTION) && model->latches == 2, "setOutputs(false) and setPhaseShift(false)");
+    dataVu.setConfig(CHIP_DEFAULT_CONFIG | CHIP_CORRECTION);
+
+    // A command corrupted on the way to the last chip leaves it out of step, unless it was
+    // caught by DATAVU_VERIFY. resync brings the chips back to the library's state.
+    model->clearStats();
+    model->glitchBit = LT8500_FRAME_BITS;
+    dataVu.setCal(false);
+    if (not configIs(CHIP_DEFAULT_CONFIG)) {
+        dataVu.resync();
+    }
+    check(configIs(CHIP_DEFAULT_CONFIG) && correctionIs(a), "resync did not restore the chips");
+    dataVu.writeFrame();
+    checkFrame(dataVu);
+}
+
+/**
+    With DATAVU_LATCH_SYNC frames keep clear of the end of the PWM period and report the
+    boundary they are shown at
+*/
+static void checkLatchSync(DataVu &dataVu, unsigned long frames = 1000) {
+#if DATAVU_LATCH_SYNC
+    unsigned long period = dataVu.getPwmPeriod();
+    check(period == LT8500_PWM_PERIOD * 1000000ULL / hostPclkHz(), "getPwmPeriod does not match PCLK");
+
+    // Frames written at every point of the period. The period is known to within a micros()
+    // step and the PCLK cycle in progress as the reset ended.
+    long pclkUs = (F_CPU / hostPclkHz() + F_CPU / 1000000 - 1) / (F_CPU / 1000000);
+    long tolerance = 1 + pclkUs;
+    model->clearStats();
+    bool ok = true;
+    for (unsigned long i = 0; i < frames; i++) {
+        hostAdvance(i * 37 % (period * (F_CPU / 1000000)));
+        dataVu.updateSymbol(0, i % 2 ? DATAVU_VALUE_MAX : 0);
+        dataVu.writeFrame(true);
+        uint64_t shown = model->lastLatchCycle + (LT8500_PWM_PERIOD - model->latchPhase) * (F_CPU / hostPclkHz());
+        long error = (int32_t)(dataVu.framePresented() - shown / (F_CPU / 1000000));
+        ok = ok && error >= -tolerance && error <= tolerance;
+    }
+    check(model->boundaryLatches == 0, "frame latched at the end of a PWM period");
+    check(ok, "framePresented is not the end of the PWM period the frame was latched in");
+#else
+    (void)dataVu;
+    (void)frames;
+#endif
+}
+
+/**
+    Calls writeFrameAsync part way through a blocking write, as an animation, fade or button
+    interrupt would
+*/
+class WriteInterrupter : public HostPortListener
+{
+    public:
+        DataVu *dataVu;
+        unsigned long countdown;
+        
+        void portWrite(uint8_t) override {
+            if (this->countdown && --this->countdown == 0) {
+                this->dataVu->updateSymbol(0, DATAVU_VALUE_MAX);
+                this->dataVu->writeFrameAsync();
+            }
+        }
+};
+
+/**
+    A frame written from an interrupt during a blocking write is sent after it, not inside it
+*/
+static void checkInterruptedWrite(DataVu &dataVu) {
+    dataVu.updateFrame(0);
+    dataVu.writeFrame();
+    
+    WriteInterrupter interrupter;
+    interrupter.dataVu = &dataVu;
+    interrupter.countdown = 500;
+    PORTD.attach(&interrupter);
+    model->clearStats();
+    dataVu.updateSymbol(1, DATAVU_VALUE_MAX);
+    dataVu.writeFrame();
+    PORTD.detach(&interrupter);
+    while (dataVu.isBusy()) {
+        hostAdvance(256);
+    }
+    check(interrupter.countdown == 0, "the blocking write was not interrupted");
+    check(model->frameErrors == 0, "a frame written from an interrupt was shifted inside a blocking write");
+    checkFrame(dataVu);
+}
+
+/**
+    An animation runs from update() in loop() and leaves the Timer0 compare vector alone
+*/
+static void checkAnim(DataVu &dataVu) {
+    static const uint8_t flash[] PROGMEM = {
+        ANIM_FILL(255), ANIM_HOLD(2),
+        ANIM_FILL(0), ANIM_END()
+    };
+    DataVuAnim anim(dataVu);
+    anim.start(flash, 5);
+    check(dataVu.getSymbol(0) == 255 * DATAVU_VALUE_SCALE && anim.running(), "animation did not show its first frame");
+    for (int ms = 0; ms < 20 && anim.running(); ms++) {
+        hostAdvance(F_CPU / 1000);
+        anim.update();
+    }
+    check(not anim.running() && dataVu.getSymbol(0) == 0 && anim.position() == 2, "update did not play the animation");
+    check(not (TIMSK0 & (1 << OCIE0A)), "animation enabled the Timer0 compare interrupt without DATAVU_ANIM_ISR");
+    while (dataVu.isBusy()) {
+        hostAdvance(256);
+    }
+    checkFrame(dataVu);
+}
+
+static void checkFade(DataVu &dataVu) {
+    DataVuFade fade(dataVu);
+    dataVu.updateFrame(0);
+    fade.fadeAllTo(DATAVU_VALUE_MAX, 10, FADE_EASE_IN_OUT, 2);
+    check(fade.running(), "fade did not start");
+    for (int ms = 0; ms < 30 && fade.running(); ms++) {
+        hostAdvance(F_CPU / 1000);
+        fade.update();
+    }
+    check(not fade.running() && dataVu.getSymbol(0) == DATAVU_VALUE_MAX, "update did not finish the fade");
+    check(not (TIMSK0 & (1 << OCIE0B)), "fade enabled the Timer0 compare interrupt without DATAVU_FADE_ISR");
+    while (dataVu.isBusy()) {
+        hostAdvance(256);
+    }
+    checkFrame(dataVu);
+}
+
+// Share of the time PCLK spent at its most used frequency while dithered
+static double ditherPeakShare = 1;
+
+/**
+    PCLK and refresh rate set from Timer2
+*/
+static void checkPwmClock(DataVu &dataVu) {
+    check(dataVu.getPwmClock() == PCLK_MAX_HZ && hostPclkHz() == PCLK_MAX_HZ, "PCLK is not F_CPU / 2 after begin");
+    check(dataVu.setPwmClock(0) == 0 && dataVu.setPwmClock(PCLK_MAX_HZ + 1) == 0, "setPwmClock accepted a frequency out of range");
+    check(dataVu.setPwmClock(1000000) == 1000000 && hostPclkHz() == 1000000, "setPwmClock(1000000) did not set PCLK");
+    check(dataVu.getPwmPeriod() == 4096, "getPwmPeriod does not match PCLK");
+    check(dataVu.setPwmClock(PCLK_MIN_HZ) == hostPclkHz() && hostPclkHz() >= PCLK_MIN_HZ, "setPwmClock(PCLK_MIN_HZ) did not set PCLK");
+
+    // 100Hz is 409.6kHz, the closest is F_CPU / 39
+    float rate = dataVu.setRefreshRate(100);
+    check(rate == hostPclkHz() / 4096.0f && hostPclkHz() == F_CPU / 39, "setRefreshRate(100) did not pick the closest PCLK");
+    checkLatchSync(dataVu);
+
+    // Over an hour with interrupts masked, so micros() wraps before the next latch. The
+    // period does not divide 2^32us, the boundary moves 256us with each wrap.
+    uint8_t sreg = SREG;
+    cli();
+    for (int i = 0; i < 18; i++) {
+        hostAdvance(0xF0000000);
+    }
+    SREG = sreg;
+    checkLatchSync(dataVu);
+    dataVu.setPwmClock(PCLK_MAX_HZ);
+    checkLatchSync(dataVu);
+
+    // PCLK changed at points spread over the PWM period
+    for (unsigned long i = 0; i < 24; i++) {
+        hostAdvance(i * 997 % (dataVu.getPwmPeriod() * (F_CPU / 1000000)));
+        dataVu.setPwmClock(i % 2 ? PCLK_MAX_HZ : F_CPU / 39);
+        checkLatchSync(dataVu, 50);
+    }
+
+#if DATAVU_LATCH_SYNC
+    // At the slowest PCLK the guard is half a second, longer than one delayMicroseconds() and
+    // too long to wait in an interrupt. Frames written about 1, 11 and 21 PCLKs before the end
+    // of the period wait for the next.
+    dataVu.setPwmClock(PCLK_MIN_HZ);
+    uint64_t pclk = dataVu.getPwmPeriod() * (F_CPU / 1000000) / LT8500_PWM_PERIOD;
+    long tolerance = 1 + pclk / (F_CPU / 1000000);
+    model->clearStats();
+    bool ok = true;
+    for (int i = 0; i < 3; i++) {
+        dataVu.writeFrame(true);
+        uint64_t boundary = model->lastLatchCycle + (LT8500_PWM_PERIOD - model->latchPhase) * pclk;
+        hostAdvance(boundary - (1 + 10 * i) * pclk - hostCycles());
+#if DATAVU_ASYNC
+        // The engine waits between Timer1 overflows, not inside one
+        uint64_t start = hostCycles();
+        unsigned long polls = 0;
+        dataVu.writeFrameAsync(true);
+        while (dataVu.isBusy()) {
+            hostAdvance(256);
+            polls++;
+        }
+        ok = ok && hostCycles() - start <= polls * 256 + F_CPU / 1000;
+#else
+        dataVu.writeFrame(true);
+#endif
+        uint64_t shown = model->lastLatchCycle + (LT8500_PWM_PERIOD - model->latchPhase) * pclk;
+        long error = (int32_t)(dataVu.framePresented() - shown / (F_CPU / 1000000));
+        ok = ok && error >= -tolerance && error <= tolerance;
+    }
+    check(model->boundaryLatches == 0 && ok, "frame at PCLK_MIN_HZ did not wait for the next PWM period");
+    dataVu.setPwmClock(PCLK_MAX_HZ);
+#endif
+}
+
+/**
+    PCLK swept around its setting with DATAVU_PWM_DITHER, keeping at least the same average
+*/
+static void checkDither(DataVu &dataVu) {
+#if DATAVU_PWM_DITHER
+    unsigned long nominal = dataVu.setPwmClock(1000000);
+    check(dataVu.setPwmDither(15) == 1, "setPwmDither accepted a sweep past OCR2A 1");
+    check(dataVu.setPwmDither(4) == 0, "setPwmDither(4) failed");
+
+    // Time at each frequency over 100ms
+    std::map<uint32_t, unsigned long> time;
+    uint64_t start = hostPclkCycles();
+    for (unsigned long i = 0; i < F_CPU / 10 / 64; i++) {
+        time[hostPclkHz()]++;
+        hostAdvance(64);
+    }
+    double average = (hostPclkCycles() - start) * 10.0;
+    unsigned long peak = 0;
+    for (const auto &entry : time) {
+        peak = std::max(peak, entry.second);
+    }
+    ditherPeakShare = peak / (F_CPU / 10.0 / 64);
+    check(time.size() == 9, "PCLK was not swept over 9 OCR2A steps");
+    check(average >= nominal, "dithering lowered the average PCLK");
+
+    // Frames are still sent from the shared Timer1 interrupt
+#if DATAVU_ASYNC
+    dataVu.updateFrame(DATAVU_VALUE_MAX / 3);
+    dataVu.writeFrameAsync();
+    while (dataVu.isBusy()) {
+        hostAdvance(256);
+    }
+    checkFrame(dataVu);
+#endif
+
+    check(dataVu.setPwmDither(0) == 0 && hostPclkHz() == nominal, "setPwmDither(0) did not stop the sweep");
+    check(not (TIMSK1 & (1 << TOIE1)), "Timer1 overflow interrupt left on");
+    dataVu.setPwmClock(PCLK_MAX_HZ);
+#else
+    (void)dataVu;
+#endif
+}
+
+static void runChecks(DataVu &dataVu) {
+
+    // begin resets the chips, turns correction off and enables the outputs
+    model->clearStats();
+    dataVu.begin();
+    check(model->resets == 1, "begin did not reset the chips");
+    check(model->frameErrors == 0, "begin latched a partial frame");
+    for (int n = 0; n < model->chipCount(); n++) {
+        check(model->chip(n).outputEnabled, "outputs disabled after begin");
+        check(not model->chip(n).correctionEnabled, "correction enabled after begin");
+        check(model->chip(n).phaseShift, "phase shift disabled after begin");
+    }
+    if (model->unknownCommands) {
+        fprintf(stderr, "note: begin latched %lu unknown LT8500 commands\n", model->unknownCommands);
+    }
+
+    // Frame contents
+    for (int i = 0; i < SYMBOL_COUNT; i++) {
+        dataVu.updateSymbol(i, (i * 37) % (DATAVU_VALUE_MAX + 1));
+    }
+    dataVu.writeFrame();
+    check(model->frameErrors == 0, "writeFrame latched a partial frame");
+    checkFrame(dataVu);
+
+    // Bulk updates leave the frame untouched on bad input
+    bool ok;
+    uint16_t vals[SYMBOL_COUNT];
+    for (int i = 0; i < SYMBOL_COUNT; i++) {
+        vals[i] = (i * 53) % (DATAVU_VALUE_MAX + 1);
+    }
+    check(dataVu.loadFrame(vals) == 0, "loadFrame rejected a valid frame");
+    dataVu.writeFrame();
+    checkFrame(dataVu);
+    vals[SYMBOL_COUNT - 1] = DATAVU_VALUE_MAX + 1;
+    check(dataVu.loadFrame(vals) == 1 && dataVu.getSymbol(0) == 0, "loadFrame accepted a bad frame");
+    uint8_t mask[SYMBOL_MASK_SIZE] = {0x05};
+    check(dataVu.fillRange(1, SYMBOL_COUNT - 1, DATAVU_VALUE_MAX) == 0 && dataVu.updateMasked(mask, 0) == 0,
+        "fillRange or updateMasked rejected valid input");
+    check(dataVu.getSymbol(1) == DATAVU_VALUE_MAX && dataVu.getSymbol(2) == 0 && dataVu.getSymbol(SYMBOL_COUNT - 1) == DATAVU_VALUE_MAX,
+        "fillRange or updateMasked set the wrong symbols");
+    check(dataVu.fillRange(2, 1, 0) == 2 && dataVu.fillRange(0, SYMBOL_COUNT, 0) == 2, "fillRange accepted a bad range");
+    dataVu.writeFrame();
+    checkFrame(dataVu);
+
+    // Master brightness 0 turns every channel off
+    dataVu.setMasterBrightness(0);
+    dataVu.writeFrame();
+    ok = true;
+    for (int i = 0; i < PWM_CHANNEL_COUNT; i++) {
+        ok = ok && model->pwm(i) == 0;
+    }
+    check(ok, "PWM registers not all 0 at master brightness 0");
+    dataVu.setMasterBrightness(255);
+    dataVu.writeFrame();
+    checkFrame(dataVu);
+
+#if DIGIT_COUNT == 6
+    // Numbers on the digits
+    dataVu.updateFrame(0);
+    check(dataVu.displayNumber(-42) == 0 && checkDigits(dataVu, "   -42"), "displayNumber(-42)");
+    check(dataVu.displayNumber(7, 2, NUMBER_LEFT) == 0 && checkDigits(dataVu, "007   "), "displayNumber left justified");
+    check(dataVu.displayNumber(305, 0, NUMBER_ZEROS) == 0 && checkDigits(dataVu, "000305"), "displayNumber zero padded");
+    check(dataVu.displayNumber(-99999) == 0 && checkDigits(dataVu, "-99999"), "displayNumber(-99999)");
+    check(dataVu.displayNumber(-100000) == 2 && checkDigits(dataVu, "------"), "displayNumber overflow");
+    check(dataVu.displayNumber(1000000) == 2, "displayNumber overflow");
+    check(dataVu.displayHex(0xBEEF) == 0 && checkDigits(dataVu, "  bEEF"), "displayHex(0xBEEF)");
+    check(dataVu.displayHex(0x1000000) == 2 && checkDigits(dataVu, "------"), "displayHex overflow");
+#endif
+
+    // Correction values land in the correction registers
+    int cal[SYMBOL_COUNT];
+    for (int i = 0; i < SYMBOL_COUNT; i++) {
+        cal[i] = (i * 5) % 64;
+    }
+    dataVu.writeCal(cal);
+    ok = true;
+    for (int i = 0; i < PWM_CHANNEL_COUNT; i++) {
+        int16_t symbol = readSymbol(&SYMBOL_MAP[i]);
+        ok = ok && model->correction(i) == (symbol < 0 ? 0 : cal[symbol]);
+    }
+    check(ok, "correction registers do not match writeCal");
+
+    // Correction is only used when turned on
+    dataVu.setCal(true);
+    check(model->chip(0).correctionEnabled, "setCal(true) did not enable correction");
+    dataVu.setCal(false);
+    check(not model->chip(0).correctionEnabled, "setCal(false) did not disable correction");
+
+    checkCalStore(dataVu);
+    checkSplash(dataVu);
+    checkReadback(dataVu);
+    checkShadow(dataVu);
+    checkInterruptedWrite(dataVu);
+    checkAnim(dataVu);
+    checkFade(dataVu);
+    checkLatchSync(dataVu);
+    checkPwmClock(dataVu);
+    checkDither(dataVu);
+}
+
+////////////////////////////////////////////RUNNER/////////////////////////////////////////////
+
+static Result runBenchmark(DataVu &dataVu, const Benchmark &bm, double minTime) {
+
+    typedef std::chrono::steady_clock Clock;
+    Result result;
+    result.name = bm.name;
+
+    // Grow the iteration count until the run is long enough to time
+    unsigned long iterations = 1;
+    while (true) {
+        model->clearStats();
+        counter.writes = 0;
+        State state(dataVu, iterations);
+        Clock::time_point start = Clock::now();
+        bm.run(state);
+        double seconds = std::chrono::duration<double>(Clock::now() - start).count();
+
+        if (seconds >= minTime || iterations >= 1000000000UL) {
+            result.iterations = iterations;
+            result.ns = seconds * 1e9 / iterations;
+            result.portWrites = (double)counter.writes / iterations;
+            result.bits = (double)model->bits / iterations;
+            result.latches = (double)model->latches / iterations;
+            return result;
+        }
+
+        // Aim for the minimum time with some margin, at most ten times the iterations
+        double scale = seconds > 0 ? minTime * 1.4 / seconds : 10;
+        iterations = iterations * (scale < 10 ? scale : 10) + 1;
+    }
+}
+
+// Bytes of flash taken by SYMBOL_MAP, SEVSEG_MAP and the character set
+static unsigned long mapFlashBytes() {
+    unsigned long bytes = sizeof(SYMBOL_MAP);
+#if DIGIT_COUNT > 0
+    bytes += sizeof(SEVSEG_MAP) + sizeof(CHARACTERARRAY);
+#endif
+    return bytes;
+}
+
+static void printConsole(const std::vector<Result> &results) {
+    printf("%s display, %d LT8500, first light %.0f us after begin, maps %lu bytes of flash\n",
+        DISPLAY_TYPE, LT8500_COUNT, bootLightUs, mapFlashBytes());
+    printf("%-28s %14s %12s %14s %10s %10s\n", "Benchmark", "Time", "Iterations", "port_writes", "bits", "latches");
+    printf("-----------------------------------------------------------------------------------------------\n");
+    for (const Result &r : results) {
+        printf("%-28s %11.1f ns %12lu %14.1f %10.1f %10.2f\n",
+            r.name.c_str(), r.ns, r.iterations, r.portWrites, r.bits, r.latches);
+    }
+}
+
+static void printJson(const std::vector<Result> &results) {
+    printf("{\n");
+    printf("  \"context\": {\n");
+    printf("    \"library_version\": \"%s\",\n", DATAVULIB_VERSION);
+    printf("    \"display_type\": \"%s\",\n", DISPLAY_TYPE);
+    printf("    \"lt8500_count\": %d,\n", LT8500_COUNT);
+    printf("    \"packed_frame\": %d,\n", DATAVU_PACKED_FRAME);
+    printf("    \"async\": %d,\n", DATAVU_ASYNC);
+    printf("    \"verify\": %d,\n", DATAVU_VERIFY);
+    printf("    \"latch_sync\": %d,\n", DATAVU_LATCH_SYNC);
+    printf("    \"pwm_dither\": %d,\n", DATAVU_PWM_DITHER);
+    printf("    \"dither_peak_share\": %.3f,\n", ditherPeakShare);
+    printf("    \"gamma\": %d,\n", DATAVU_GAMMA);
+    printf("    \"fast_boot\": %d,\n", DATAVU_FAST_BOOT);
+    printf("    \"boot_to_light_us\": %.1f,\n", bootLightUs);
+    printf("    \"map_flash_bytes\": %lu\n", mapFlashBytes());
+    printf("  },\n");
+    printf("  \"benchmarks\": [\n");
+    for (size_t i = 0; i < results.size(); i++) {
+        const Result &r = results[i];
+        printf("    {\n");
+        printf("      \"name\": \"%s\",\n", r.name.c_str());
+        printf("      \"iterations\": %lu,\n", r.iterations);
+        printf("      \"real_time\": %.3f,\n", r.ns);
+        printf("      \"time_unit\": \"ns\",\n");
+        printf("      \"port_writes\": %.3f,\n", r.portWrites);
+        printf("      \"bits\": %.3f,\n", r.bits);
+        printf("      \"latches\": %.3f\n", r.latches);
+        printf("    }%s\n", i + 1 < results.size() ? "," : "");
+    }
+    printf("  ]\n");
+    printf("}\n");
+}
+
+int main(int argc, char **argv) {
+
+    std::string filter = ".";
+    bool json = false;
+    double minTime = 0.2;
+
+    for (int i = 1; i < argc; i++) {
+        std::string arg = argv[i];
+        if (arg.compare(0, 9, "--filter=") == 0) {
+            filter = arg.substr(9);
+        }
+        else if (arg == "--format=json") {
+            json = true;
+        }
+        else if (arg == "--format=console") {
+            json = false;
+        }
+        else if (arg.compare(0, 11, "--min_time=") == 0) {
+            minTime = atof(arg.c_str() + 11);
+        }
+        else {
+            fprintf(stderr, "usage: %s [--filter=<regex>] [--format=console|json] [--min_time=<seconds>]\n", argv[0]);
+            return 2;
+        }
+    }
+
+    // Power on the MCU with the chips on PORTD
+    hostReset();
+    LT8500Chain chain(PORTD, PWM_SDI, PWM_SCKI, PWM_LATCH, LT8500_COUNT, PWM_SDO);
+    model = &chain;
+    PORTD.attach(&counter);
+    DataVu dataVu;
+
+    runChecks(dataVu);
+    if (failures) {
+        return 1;
+    }
+
+    std::regex re(filter);
+    std::vector<Result> results;
+    for (const Benchmark &bm : BENCHMARKS) {
+        if (std::regex_search(bm.name, re)) {
+            results.push_back(runBenchmark(dataVu, bm, minTime));
+        }
+    }
+
+    if (json) {
+        printJson(results);
+    }
+    else {
+        printConsole(results);
+    }
+    return 0;
+}
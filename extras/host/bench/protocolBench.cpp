@@ -0,0 +1,447 @@
+/******************************************************************************
+    This file is part of the host build of the Data-Vu evaluation kit library
+    created by Plessey Semiconductors. It benchmarks the serial protocols of
+    the Data-Vu firmware.
+
+    Copyright (C) 2019  <Gethn Pickard>
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <https://www.gnu.org/licenses/>.
+******************************************************************************/
+
+/*
+    Frame throughput of the dataVuFW sketch over its text CLI and its binary protocol. The
+    sketch is built unchanged with Cmd.cpp and Bin.cpp, and each iteration sends it one new
+    frame, latched, then runs loop():
+
+        BM_text         u <SYMBOL_COUNT values> and w command lines, echoed by Cmd.cpp
+        BM_frame8       BIN_FRAME8 | BIN_LATCH packet, COBS encoded, applied by bin_frame
+        BM_frame12      BIN_FRAME12 | BIN_LATCH packet, not built with DATAVU_GAMMA
+
+    Along with the host time each benchmark reports per frame:
+
+        rx_bytes        Bytes read by the sketch
+        tx_bytes        Bytes written by the sketch, echo and prompts or the reply
+        frames_per_s    Frames a second at the sketch's baud rate. The UART is full duplex,
+                        so a frame takes the longer of its rx and tx bytes at 10 bits each,
+                        plus the frame write on the virtual clock. Parsing is not timed on
+                        the virtual clock.
+
+        protocolBench [--filter=<regex>] [--format=console|json] [--min_time=<seconds>]
+
+    Before timing anything each protocol sends a frame that is checked against the frame
+    buffer and the reply. The exit code is 1 if a check fails.
+*/
+
+#include <chrono>
+#include <regex>
+#include <string>
+#include <vector>
+#include <stdio.h>
+
+#include <util/crc16.h>
+#include "dataVuHost.h"
+#include "lt8500Model.h"
+
+// Prototypes the Arduino IDE generates for the sketch
+int cli_help(int, char **);
+int cli_v(int, char **);
+int cli_ua(int, char **);
+int cli_us(int, char **);
+int cli_u(int, char **);
+int cli_u_arg(uint8_t, uint16_t);
+int cli_ud(int, char **);
+int cli_w(int, char **);
+int cli_cOn(int, char **);
+int cli_cOff(int, char **);
+int cli_c(int, char **);
+int cli_c_arg(uint8_t, uint16_t);
+int cli_cp(int, char **);
+int cli_cn(int, char **);
+int cli_s(int, char **);
+int cli_sc(int, char **);
+int cli_d(int, char **);
+int cli_r(int, char **);
+int cli_m(int, char **);
+int cli_b(int, char **);
+int bin_frame(uint8_t, uint8_t *, uint8_t);
+
+// The sketch's index global would clash with index() from the C library
+#define index sketchIndex
+#include "dataVuFW.ino"
+#undef index
+
+/*
+    Loop state of one benchmark run
+*/
+class State
+{
+    public:
+        unsigned long iterations;
+        unsigned long index;
+
+        State(unsigned long iterations) : iterations(iterations), index(0) {}
+        bool next() { return this->index++ < this->iterations; }
+};
+
+struct Benchmark
+{
+    const char *name;
+    void (*run)(State &);
+};
+
+struct Result
+{
+    std::string name;
+    unsigned long iterations;
+    double ns;
+    double rxBytes;
+    double txBytes;
+    double framesPerS;
+};
+
+static LT8500Chain *model;
+
+// Frame values of one iteration, 0-255, different in every frame so none is skipped
+static uint8_t frameValue(unsigned long frame, int symbol) {
+    return (frame * 7 + symbol * 13) & 0xFF;
+}
+
+//////////////////////////////////////////PROTOCOLS////////////////////////////////////////////
+
+/**
+    Send a frame as u and w command lines
+*/
+static void sendText(unsigned long frame) {
+    char line[8];
+    Serial.send("u");
+    for (int i = 0; i < SYMBOL_COUNT; i++) {
+        snprintf(line, sizeof(line), " %u", frameValue(frame, i));
+        Serial.send(line);
+    }
+    Serial.send("\rw\r");
+}
+
+/**
+    COBS encode a packet with its CRC and send it with a zero terminator
+*/
+static void sendPacket(uint8_t type, uint8_t seq, const uint8_t *payload, uint8_t len) {
+    uint8_t pkt[BIN_MAX_PAYLOAD + 4];
+    pkt[0] = type;
+    pkt[1] = seq;
+    memcpy(pkt + 2, payload, len);
+    uint16_t crc = 0xFFFF;
+    for (int i = 0; i < len + 2; i++) {
+        crc = _crc_ccitt_update(crc, pkt[i]);
+    }
+    pkt[len + 2] = crc;
+    pkt[len + 3] = crc >> 8;
+
+    uint8_t out[BIN_MAX_PAYLOAD + 8];
+    int code = 0, n = 1;
+    for (int i = 0; i < len + 4; i++) {
+        if (pkt[i] == 0) {
+            out[code] = n - code;
+            code = n++;
+        }
+        else {
+            out[n++] = pkt[i];
+            if (n - code == 0xFF) {
+                out[code] = 0xFF;
+                code = n++;
+            }
+        }
+    }
+    out[code] = n - code;
+    out[n++] = 0;
+    Serial.send(out, n);
+}
+
+/**
+    Send a frame of eight bit values
+*/
+static void sendFrame8(unsigned long frame) {
+    uint8_t data[SYMBOL_COUNT];
+    for (int i = 0; i < SYMBOL_COUNT; i++) {
+        data[i] = frameValue(frame, i);
+    }
+    sendPacket(BIN_FRAME8 | BIN_LATCH, frame, data, SYMBOL_COUNT);
+}
+
+/**
+    Send a frame of twelve bit values, the eight bit values scaled as the text command does.
+    Not built with DATAVU_GAMMA.
+*/
+#if !DATAVU_GAMMA
+static void sendFrame12(unsigned long frame) {
+    uint8_t data[FRAME12_SIZE] = {0};
+    for (int i = 0; i < SYMBOL_COUNT; i++) {
+        uint16_t val = frameValue(frame, i) * DATAVU_VALUE_SCALE;
+        uint8_t *p = data + i * 3 / 2;
+        if (i & 1) {
+            p[0] |= val >> 8;
+            p[1] = val;
+        }
+        else {
+            p[0] = val >> 4;
+            p[1] = (val & 0x0F) << 4;
+        }
+    }
+    sendPacket(BIN_FRAME12 | BIN_LATCH, frame, data, FRAME12_SIZE);
+}
+#endif
+
+/////////////////////////////////////////BENCHMARKS////////////////////////////////////////////
+
+// Frames sent so far, sequence numbers of the packets
+static unsigned long frames;
+
+// Virtual cycles spent in loop() by the last run
+static uint64_t loopCycles;
+
+static void runProtocol(State &state, void (*send)(unsigned long)) {
+    while (state.next()) {
+        send(++frames);
+        uint64_t start = hostCycles();
+        loop();
+        loopCycles += hostCycles() - start;
+    }
+}
+
+static void BM_text(State &state) {
+    runProtocol(state, sendText);
+}
+
+static void BM_frame8(State &state) {
+    runProtocol(state, sendFrame8);
+}
+
+#if !DATAVU_GAMMA
+static void BM_frame12(State &state) {
+    runProtocol(state, sendFrame12);
+}
+#endif
+
+static const Benchmark TEXT_BENCHMARKS[] = {
+    {"BM_text", BM_text},
+};
+
+static const Benchmark BINARY_BENCHMARKS[] = {
+    {"BM_frame8", BM_frame8},
+#if !DATAVU_GAMMA
+    {"BM_frame12", BM_frame12},
+#endif
+};
+
+///////////////////////////////////////////CHECKS//////////////////////////////////////////////
+
+static int failures;
+
+static void check(bool ok, const char *what) {
+    if (!ok) {
+        fprintf(stderr, "protocol check failed: %s\n", what);
+        failures++;
+    }
+}
+
+/**
+    Check the frame buffer holds a frame sent and the model latched it
+*/
+static bool frameIs(unsigned long frame) {
+    for (int i = 0; i < SYMBOL_COUNT; i++) {
+        if (dataVu.getSymbol(i) != frameValue(frame, i) * DATAVU_VALUE_SCALE) {
+            return false;
+        }
+    }
+    return model->latches > 0;
+}
+
+/**
+    Check a reply was sent since tx bytes were written and had no error
+*/
+static bool textOk(unsigned long tx) {
+    for (unsigned long back = 1; back <= Serial.txBytes - tx; back++) {
+        if (Serial.sent(back) == CMD_ERROR) {
+            return false;
+        }
+    }
+    return Serial.txBytes > tx && Serial.sent(1) == CMD_PROMPT;
+}
+
+/**
+    Check a binary packet was answered with BIN_OK. The zero status is the first byte of the
+    reply and COBS encodes it as a block code of 1, the whole reply being six bytes.
+*/
+static bool replyOk() {
+    return Serial.sent(6) == 1 && Serial.sent(1) == 0;
+}
+
+static void checkText() {
+    unsigned long tx = Serial.txBytes;
+    model->clearStats();
+    sendText(++frames);
+    loop();
+    check(frameIs(frames), "text frame not applied");
+    check(textOk(tx), "text frame not accepted");
+}
+
+static void checkBinary() {
+    Serial.send("b\r");
+    loop();
+    check(binActive(), "b did not enter binary mode");
+
+    model->clearStats();
+    sendFrame8(++frames);
+    loop();
+    check(frameIs(frames) && replyOk(), "eight bit frame not applied");
+#if !DATAVU_GAMMA
+    model->clearStats();
+    sendFrame12(++frames);
+    loop();
+    check(frameIs(frames) && replyOk(), "twelve bit frame not applied");
+#endif
+}
+
+////////////////////////////////////////////RUNNER/////////////////////////////////////////////
+
+static Result runBenchmark(const Benchmark &bm, double minTime) {
+
+    typedef std::chrono::steady_clock Clock;
+    Result result;
+    result.name = bm.name;
+
+    // Grow the iteration count until the run is long enough to time
+    unsigned long iterations = 1;
+    while (true) {
+        unsigned long rx = Serial.rxBytes, tx = Serial.txBytes;
+        loopCycles = 0;
+        State state(iterations);
+        Clock::time_point start = Clock::now();
+        bm.run(state);
+        double seconds = std::chrono::duration<double>(Clock::now() - start).count();
+
+        if (seconds >= minTime || iterations >= 1000000000UL) {
+            result.iterations = iterations;
+            result.ns = seconds * 1e9 / iterations;
+            result.rxBytes = (double)(Serial.rxBytes - rx) / iterations;
+            result.txBytes = (double)(Serial.txBytes - tx) / iterations;
+            double wire = (result.rxBytes > result.txBytes ? result.rxBytes : result.txBytes) * 10 / Serial.baud;
+            result.framesPerS = 1 / (wire + (double)loopCycles / iterations / F_CPU);
+            return result;
+        }
+
+        // Aim for the minimum time with some margin, at most ten times the iterations
+        double scale = seconds > 0 ? minTime * 1.4 / seconds : 10;
+        iterations = iterations * (scale < 10 ? scale : 10) + 1;
+    }
+}
+
+static void printConsole(const std::vector<Result> &results) {
+    printf("%s display, %d LT8500, %lu baud\n", DISPLAY_TYPE, LT8500_COUNT, Serial.baud);
+    printf("%-28s %14s %12s %10s %10s %14s\n", "Benchmark", "Time", "Iterations", "rx_bytes", "tx_bytes", "frames_per_s");
+    printf("-----------------------------------------------------------------------------------------------\n");
+    for (const Result &r : results) {
+        printf("%-28s %11.1f ns %12lu %10.1f %10.1f %14.2f\n",
+            r.name.c_str(), r.ns, r.iterations, r.rxBytes, r.txBytes, r.framesPerS);
+    }
+}
+
+static void printJson(const std::vector<Result> &results) {
+    printf("{\n");
+    printf("  \"context\": {\n");
+    printf("    \"library_version\": \"%s\",\n", DATAVULIB_VERSION);
+    printf("    \"firmware_version\": \"%s\",\n", DATAVUFW_VERSION);
+    printf("    \"display_type\": \"%s\",\n", DISPLAY_TYPE);
+    printf("    \"lt8500_count\": %d,\n", LT8500_COUNT);
+    printf("    \"gamma\": %d,\n", DATAVU_GAMMA);
+    printf("    \"baud\": %lu\n", Serial.baud);
+    printf("  },\n");
+    printf("  \"benchmarks\": [\n");
+    for (size_t i = 0; i < results.size(); i++) {
+        const Result &r = results[i];
+        printf("    {\n");
+        printf("      \"name\": \"%s\",\n", r.name.c_str());
+        printf("      \"iterations\": %lu,\n", r.iterations);
+        printf("      \"real_time\": %.3f,\n", r.ns);
+        printf("      \"time_unit\": \"ns\",\n");
+        printf("      \"rx_bytes\": %.3f,\n", r.rxBytes);
+        printf("      \"tx_bytes\": %.3f,\n", r.txBytes);
+        printf("      \"frames_per_s\": %.3f\n", r.framesPerS);
+        printf("    }%s\n", i + 1 < results.size() ? "," : "");
+    }
+    printf("  ]\n");
+    printf("}\n");
+}
+
+int main(int argc, char **argv) {
+
+    std::string filter = ".";
+    bool json = false;
+    double minTime = 0.2;
+
+    for (int i = 1; i < argc; i++) {
+        std::string arg = argv[i];
+        if (arg.compare(0, 9, "--filter=") == 0) {
+            filter = arg.substr(9);
+        }
+        else if (arg == "--format=json") {
+            json = true;
+        }
+        else if (arg == "--format=console") {
+            json = false;
+        }
+        else if (arg.compare(0, 11, "--min_time=") == 0) {
+            minTime = atof(arg.c_str() + 11);
+        }
+        else {
+            fprintf(stderr, "usage: %s [--filter=<regex>] [--format=console|json] [--min_time=<seconds>]\n", argv[0]);
+            return 2;
+        }
+    }
+
+    // Power on the MCU with the chips on PORTD and run the sketch's setup
+    hostReset();
+    LT8500Chain chain(PORTD, PWM_SDI, PWM_SCKI, PWM_LATCH, LT8500_COUNT, PWM_SDO);
+    model = &chain;
+    setup();
+
+    // The CLI runs first, binary mode is entered with b and kept
+    std::regex re(filter);
+    std::vector<Result> results;
+    checkText();
+    if (failures) {
+        return 1;
+    }
+    for (const Benchmark &bm : TEXT_BENCHMARKS) {
+        if (std::regex_search(bm.name, re)) {
+            results.push_back(runBenchmark(bm, minTime));
+        }
+    }
+    checkBinary();
+    if (failures) {
+        return 1;
+    }
+    for (const Benchmark &bm : BINARY_BENCHMARKS) {
+        if (std::regex_search(bm.name, re)) {
+            results.push_back(runBenchmark(bm, minTime));
+        }
+    }
+
+    if (json) {
+        printJson(results);
+    }
+    else {
+        printConsole(results);
+    }
+    return 0;
+}
@@ -0,0 +1,65 @@
+/******************************************************************************
+    This file is part of the host build of the Data-Vu evaluation kit library
+    created by Plessey Semiconductors. It stands in for the Arduino EEPROM
+    library with 1KB of erased (0xFF) memory.
+
+    Copyright (C) 2019  <Gethn Pickard>
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <https://www.gnu.org/licenses/>.
+******************************************************************************/
+
+#ifndef HOST_EEPROM_H
+#define HOST_EEPROM_H
+
+#include <stdint.h>
+#include <string.h>
+
+#define HOST_EEPROM_SIZE 1024
+
+class EEPROMClass
+{
+    public:
+        uint8_t mem[HOST_EEPROM_SIZE];
+
+        // Number of bytes written, for wear measurements
+        unsigned long writes;
+
+        EEPROMClass() : writes(0) { memset(this->mem, 0xFF, sizeof(this->mem)); }
+
+        // Addresses wrap at the end of the EEPROM like the ATMega's address register
+        uint8_t read(int addr) { return this->mem[addr % HOST_EEPROM_SIZE]; }
+        void write(int addr, uint8_t val) { this->mem[addr % HOST_EEPROM_SIZE] = val; this->writes++; }
+        void update(int addr, uint8_t val) { if (this->read(addr) != val) this->write(addr, val); }
+        uint16_t length() { return HOST_EEPROM_SIZE; }
+
+        template <class T> T &get(int addr, T &t) {
+            uint8_t *p = (uint8_t *)&t;
+            for (unsigned i = 0; i < sizeof(T); i++) {
+                p[i] = this->read(addr + i);
+            }
+            return t;
+        }
+
+        template <class T> const T &put(int addr, const T &t) {
+            const uint8_t *p = (const uint8_t *)&t;
+            for (unsigned i = 0; i < sizeof(T); i++) {
+                this->update(addr + i, p[i]);
+            }
+            return t;
+        }
+};
+
+extern EEPROMClass EEPROM;
+
+#endif //HOST_EEPROM_H
@@ -0,0 +1,88 @@
+/******************************************************************************
+    This file is part of the host build of the Data-Vu evaluation kit library
+    created by Plessey Semiconductors. It stands in for the Arduino serial port.
+
+    Copyright (C) 2019  <Gethn Pickard>
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <https://www.gnu.org/licenses/>.
+******************************************************************************/
+
+#ifndef HOST_HARDWARESERIAL_H
+#define HOST_HARDWARESERIAL_H
+
+#include <stdint.h>
+#include <stdio.h>
+#include <string.h>
+
+#define HOST_SERIAL_BUFFER 512
+
+/*
+    UART0. Bytes queued by the host program with send() are returned by read(). Bytes written
+    by the sketch are counted and the last HOST_SERIAL_BUFFER of them kept in tx. No time
+    passes on the virtual clock, the host program works out the time on the wire from baud.
+*/
+class HardwareSerial
+{
+    public:
+        unsigned long baud;
+        uint8_t rx[HOST_SERIAL_BUFFER];
+        unsigned rxHead, rxTail;
+        uint8_t tx[HOST_SERIAL_BUFFER];
+        unsigned long rxBytes, txBytes;
+
+        HardwareSerial() : baud(0), rxHead(0), rxTail(0), rxBytes(0), txBytes(0) {}
+
+        // Host side
+        void send(const uint8_t *data, size_t len) {
+            for (size_t i = 0; i < len; i++) {
+                this->rx[this->rxHead++ % HOST_SERIAL_BUFFER] = data[i];
+            }
+        }
+        void send(const char *text) { this->send((const uint8_t *)text, strlen(text)); }
+        uint8_t sent(unsigned long back) { return this->tx[(this->txBytes - back) % HOST_SERIAL_BUFFER]; }
+
+        // Sketch side
+        void begin(unsigned long baud) { this->baud = baud; }
+        int available() { return this->rxHead - this->rxTail; }
+        int read() {
+            if (this->rxTail == this->rxHead) {
+                return -1;
+            }
+            this->rxBytes++;
+            return this->rx[this->rxTail++ % HOST_SERIAL_BUFFER];
+        }
+        size_t write(uint8_t c) {
+            this->tx[this->txBytes++ % HOST_SERIAL_BUFFER] = c;
+            return 1;
+        }
+        size_t write(const uint8_t *data, size_t len) {
+            for (size_t i = 0; i < len; i++) {
+                this->write(data[i]);
+            }
+            return len;
+        }
+        size_t print(const char *text) { return this->write((const uint8_t *)text, strlen(text)); }
+        size_t print(char c) { return this->write((uint8_t)c); }
+        size_t print(long n) { char buf[12]; snprintf(buf, sizeof(buf), "%ld", n); return this->print(buf); }
+        size_t print(unsigned long n) { char buf[12]; snprintf(buf, sizeof(buf), "%lu", n); return this->print(buf); }
+        size_t print(int n) { return this->print((long)n); }
+        size_t print(unsigned int n) { return this->print((unsigned long)n); }
+        size_t print(double n) { char buf[24]; snprintf(buf, sizeof(buf), "%.2f", n); return this->print(buf); }
+        size_t println() { return this->print("\r\n"); }
+        template <class T> size_t println(T value) { return this->print(value) + this->println(); }
+};
+
+extern HardwareSerial Serial;
+
+#endif //HOST_HARDWARESERIAL_H
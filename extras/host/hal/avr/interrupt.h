@@ -0,0 +1,41 @@
+/******************************************************************************
+    This file is part of the host build of the Data-Vu evaluation kit library
+    created by Plessey Semiconductors. It stands in for <avr/interrupt.h>.
+
+    Copyright (C) 2019  <Gethn Pickard>
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <https://www.gnu.org/licenses/>.
+******************************************************************************/
+
+#ifndef HOST_AVR_INTERRUPT_H
+#define HOST_AVR_INTERRUPT_H
+
+#include "avr/io.h"
+
+// Interrupt handlers are plain functions, run by the virtual clock while the I bit is set
+#define ISR(vector, ...) extern "C" void vector(void)
+
+extern "C" {
+    void TIMER0_COMPA_vect(void) __attribute__((weak));
+    void TIMER0_COMPB_vect(void) __attribute__((weak));
+    void TIMER1_OVF_vect(void) __attribute__((weak));
+    void TIMER2_COMPA_vect(void) __attribute__((weak));
+    void TIMER2_COMPB_vect(void) __attribute__((weak));
+    void PCINT0_vect(void) __attribute__((weak));
+}
+
+#define cli() (SREG = SREG & ~(1 << SREG_I))
+#define sei() (SREG = SREG | (1 << SREG_I))
+
+#endif //HOST_AVR_INTERRUPT_H
@@ -0,0 +1,201 @@
+/******************************************************************************
+    This file is part of the host build of the Data-Vu evaluation kit library
+    created by Plessey Semiconductors. It stands in for <avr/io.h>.
+
+    Copyright (C) 2019  <Gethn Pickard>
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <https://www.gnu.org/licenses/>.
+******************************************************************************/
+
+#ifndef HOST_AVR_IO_H
+#define HOST_AVR_IO_H
+
+#include <stdint.h>
+
+#ifndef F_CPU
+#define F_CPU 16000000UL
+#endif
+
+// Last EEPROM address of the ATMega328
+#define E2END 0x3FF
+
+// Most models that can listen to one port
+#define HOST_PORT_LISTENERS 4
+
+/*
+    Anything driven by port pins, e.g. the LT8500 model. portWrite is called after every
+    write to the port with the new output value.
+*/
+class HostPortListener
+{
+    public:
+        virtual void portWrite(uint8_t value) = 0;
+};
+
+/*
+    Output register of an I/O port. Every write costs one CPU cycle on the virtual clock,
+    the same as an out instruction, and is passed to the listeners. Compound assignments
+    take the promoted operand, as the AVR compiler does for a volatile uint8_t register.
+*/
+class HostPort
+{
+    public:
+        uint8_t out;        // PORTx output latch
+        uint8_t in;         // Levels driven onto the pins by models
+        uint8_t ddr;        // DDRx, set by pinMode
+        HostPortListener *listeners[HOST_PORT_LISTENERS];
+
+        HostPort &operator=(uint8_t value);
+        HostPort &operator|=(unsigned long value) { return *this = (uint8_t)(this->out | value); }
+        HostPort &operator&=(unsigned long value) { return *this = (uint8_t)(this->out & value); }
+        HostPort &operator^=(unsigned long value) { return *this = (uint8_t)(this->out ^ value); }
+        operator uint8_t() const { return this->out; }
+
+        void attach(HostPortListener *listener);
+        void detach(HostPortListener *listener);
+        uint8_t pins() const { return (this->out & this->ddr) | (this->in & ~this->ddr); }
+};
+
+/*
+    PINx input register of a port
+*/
+class HostPin
+{
+    public:
+        HostPort &port;
+        operator uint8_t() const { return this->port.pins(); }
+};
+
+/*
+    Status register. Setting the I bit runs any interrupts that are due.
+*/
+class HostSreg
+{
+    public:
+        uint8_t value;
+
+        HostSreg &operator=(uint8_t value);
+        operator uint8_t() const { return this->value; }
+};
+
+extern HostPort PORTB, PORTC, PORTD;
+extern HostPin PINB, PINC, PIND;
+extern HostSreg SREG;
+#define DDRB (PORTB.ddr)
+#define DDRC (PORTC.ddr)
+#define DDRD (PORTD.ddr)
+
+// Timer and interrupt registers. Timers are run by the virtual clock, see dataVuHost.h.
+extern volatile uint8_t TCCR0A, TCCR0B, TCNT0, OCR0A, OCR0B, TIMSK0, TIFR0;
+extern volatile uint8_t TCCR1A, TCCR1B, TCCR1C, TIMSK1, TIFR1;
+extern volatile uint16_t TCNT1, OCR1A, OCR1B, ICR1;
+extern volatile uint8_t TCCR2A, TCCR2B, TCNT2, OCR2A, OCR2B, TIMSK2, TIFR2;
+extern volatile uint8_t PCICR, PCIFR, PCMSK0, PCMSK1, PCMSK2, EICRA, EIMSK;
+
+// SREG
+#define SREG_I  7
+
+// Timer0
+#define COM0A1  7
+#define COM0A0  6
+#define COM0B1  5
+#define COM0B0  4
+#define WGM01   1
+#define WGM00   0
+#define WGM02   3
+#define CS02    2
+#define CS01    1
+#define CS00    0
+#define OCIE0B  2
+#define OCIE0A  1
+#define TOIE0   0
+#define OCF0B   2
+#define OCF0A   1
+#define TOV0    0
+
+// Timer1
+#define COM1A1  7
+#define COM1A0  6
+#define COM1B1  5
+#define COM1B0  4
+#define WGM11   1
+#define WGM10   0
+#define ICNC1   7
+#define ICES1   6
+#define WGM13   4
+#define WGM12   3
+#define CS12    2
+#define CS11    1
+#define CS10    0
+#define ICIE1   5
+#define OCIE1B  2
+#define OCIE1A  1
+#define TOIE1   0
+#define ICF1    5
+#define OCF1B   2
+#define OCF1A   1
+#define TOV1    0
+
+// Timer2
+#define COM2A1  7
+#define COM2A0  6
+#define COM2B1  5
+#define COM2B0  4
+#define WGM21   1
+#define WGM20   0
+#define WGM22   3
+#define CS22    2
+#define CS21    1
+#define CS20    0
+#define OCIE2B  2
+#define OCIE2A  1
+#define TOIE2   0
+#define OCF2B   2
+#define OCF2A   1
+#define TOV2    0
+
+// Pin change interrupts
+#define PCIE2   2
+#define PCIE1   1
+#define PCIE0   0
+
+// Port bits
+#define PB0 0
+#define PB1 1
+#define PB2 2
+#define PB3 3
+#define PB4 4
+#define PB5 5
+#define PB6 6
+#define PB7 7
+#define PC0 0
+#define PC1 1
+#define PC2 2
+#define PC3 3
+#define PC4 4
+#define PC5 5
+#define PC6 6
+#define PD0 0
+#define PD1 1
+#define PD2 2
+#define PD3 3
+#define PD4 4
+#define PD5 5
+#define PD6 6
+#define PD7 7
+
+#define _BV(bit) (1 << (bit))
+#define _SFR_IO_ADDR(reg) 0
+
+#endif //HOST_AVR_IO_H
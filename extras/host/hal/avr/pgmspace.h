@@ -0,0 +1,46 @@
+/******************************************************************************
+    This file is part of the host build of the Data-Vu evaluation kit library
+    created by Plessey Semiconductors. It stands in for <avr/pgmspace.h>.
+    Flash and RAM share one address space on the host.
+
+    Copyright (C) 2019  <Gethn Pickard>
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <https://www.gnu.org/licenses/>.
+******************************************************************************/
+
+#ifndef HOST_AVR_PGMSPACE_H
+#define HOST_AVR_PGMSPACE_H
+
+#include <stdint.h>
+#include <string.h>
+
+#define PROGMEM
+#define PGM_P const char *
+#define PSTR(s) (s)
+
+#define pgm_read_byte(addr)         (*(const uint8_t *)(addr))
+#define pgm_read_byte_near(addr)    (*(const uint8_t *)(addr))
+#define pgm_read_word(addr)         (*(const uint16_t *)(addr))
+#define pgm_read_word_near(addr)    (*(const uint16_t *)(addr))
+#define pgm_read_dword(addr)        (*(const uint32_t *)(addr))
+#define pgm_read_ptr(addr)          (*(void * const *)(addr))
+
+#define strcpy_P    strcpy
+#define strncpy_P   strncpy
+#define strcmp_P    strcmp
+#define strncmp_P   strncmp
+#define strlen_P    strlen
+#define memcpy_P    memcpy
+
+#endif //HOST_AVR_PGMSPACE_H
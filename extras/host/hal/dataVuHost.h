@@ -0,0 +1,62 @@
+/******************************************************************************
+    This file is part of the host build of the Data-Vu evaluation kit library
+    created by Plessey Semiconductors. It gives host programs control of the
+    virtual clock that stands in for the ATMega.
+
+    Copyright (C) 2019  <Gethn Pickard>
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <https://www.gnu.org/licenses/>.
+******************************************************************************/
+
+/*
+    The virtual clock counts CPU cycles. It moves on one cycle for every port write and by
+    the requested time in delay() and delayMicroseconds(). Timer interrupts are run from it
+    while the SREG I bit is set:
+
+        Timer0      Arduino millis() timer, F_CPU/64 with a 256 count period. The compare
+                    A and B interrupts run once per period when enabled.
+        Timer1      Overflow interrupt, period from the WGM and clock select bits.
+        Timer2      Compare A and B interrupts, period from OCR2A in CTC and fast PWM mode 7.
+
+    PCLK, on OC2B, is counted as the clock runs.
+
+    As on the ATMega, a missed period leaves one interrupt pending rather than several.
+*/
+
+#ifndef DATAVU_HOST_H
+#define DATAVU_HOST_H
+
+#include <stdint.h>
+#include "Arduino.h"
+
+// Cycles since the last hostReset
+uint64_t hostCycles();
+
+// Run the virtual clock forward, running interrupts as they fall due
+void hostAdvance(uint32_t cycles);
+
+// Run any interrupts that are due. Called whenever the I bit is set.
+void hostPoll();
+
+// Put the clock, ports and timer registers back to their power on state with interrupts
+// enabled, as they are when setup() runs. EEPROM is kept.
+void hostReset();
+
+// PCLK frequency from the Timer2 settings, 0 if PCLK is not running
+uint32_t hostPclkHz();
+
+// PCLK cycles since the last hostReset
+uint64_t hostPclkCycles();
+
+#endif //DATAVU_HOST_H
@@ -0,0 +1,358 @@
+/******************************************************************************
+    This file is part of the host build of the Data-Vu evaluation kit library
+    created by Plessey Semiconductors. It implements the ports, timers and
+    virtual clock behind the host Arduino headers.
+
+    Copyright (C) 2019  <Gethn Pickard>
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <https://www.gnu.org/licenses/>.
+******************************************************************************/
+
+#include "Arduino.h"
+#include "EEPROM.h"
+#include "dataVuHost.h"
+
+// Registers
+HostPort PORTB, PORTC, PORTD;
+HostPin PINB = {PORTB}, PINC = {PORTC}, PIND = {PORTD};
+HostSreg SREG = {1 << SREG_I};
+
+volatile uint8_t TCCR0A, TCCR0B, TCNT0, OCR0A, OCR0B, TIMSK0, TIFR0;
+volatile uint8_t TCCR1A, TCCR1B, TCCR1C, TIMSK1, TIFR1;
+volatile uint16_t TCNT1, OCR1A, OCR1B, ICR1;
+volatile uint8_t TCCR2A, TCCR2B, TCNT2, OCR2A, OCR2B, TIMSK2, TIFR2;
+volatile uint8_t PCICR, PCIFR, PCMSK0, PCMSK1, PCMSK2, EICRA, EIMSK;
+
+EEPROMClass EEPROM;
+HardwareSerial Serial;
+
+// Virtual clock
+static uint64_t cycles;
+static bool inIsr;
+
+// PCLK cycles since the last hostReset, and CPU cycles into the current one
+static uint64_t pclkCycles;
+static uint32_t pclkPart;
+
+// Timer0 period set up by the Arduino core for millis()
+#define TIMER0_PERIOD (64UL * 256)
+
+// Next period boundary of each timer
+static uint64_t timer0Next = TIMER0_PERIOD;
+static uint64_t timer1Next;
+static uint64_t timer2Next;
+
+/**
+    Timer1 period in cycles, 0 when stopped
+*/
+static uint32_t timer1Period() {
+    static const uint16_t PRESCALE[8] = {0, 1, 8, 64, 256, 1024, 0, 0};
+    uint32_t prescale = PRESCALE[TCCR1B & 0x07];
+    uint8_t wgm = ((TCCR1B >> WGM12) & 0x03) << 2 | (TCCR1A & 0x03);
+    uint32_t top;
+    switch (wgm) {
+        case 1: case 5:     top = 0xFF; break;
+        case 2: case 6:     top = 0x1FF; break;
+        case 3: case 7:     top = 0x3FF; break;
+        case 4: case 15:    top = OCR1A; break;
+        case 12: case 14:   top = ICR1; break;
+        default:            top = 0xFFFF; break;
+    }
+
+    // Phase correct modes count up and down
+    if (wgm >= 1 && wgm <= 3) {
+        top *= 2;
+    }
+    return prescale * (top + 1);
+}
+
+/**
+    Timer2 prescaler, 0 when stopped
+*/
+static uint32_t timer2Prescale() {
+    static const uint16_t PRESCALE[8] = {0, 1, 8, 32, 64, 128, 256, 1024};
+    return PRESCALE[TCCR2B & 0x07];
+}
+
+/**
+    Timer2 period in cycles, 0 when stopped. CTC and fast PWM mode 7 count to OCR2A.
+*/
+static uint32_t timer2Period() {
+    uint32_t prescale = timer2Prescale();
+    uint8_t wgm = ((TCCR2B >> WGM22) & 0x01) << 2 | (TCCR2A & 0x03);
+    return prescale * (wgm == 2 || wgm == 7 ? OCR2A + 1UL : 256UL);
+}
+
+/**
+    PCLK period in cycles, 0 if OC2B is not driven. OC2B toggles each period in CTC mode and
+    makes one pulse per period in the fast PWM modes.
+*/
+static uint32_t pclkPeriod() {
+    uint8_t wgm = ((TCCR2B >> WGM22) & 0x01) << 2 | (TCCR2A & 0x03);
+    uint8_t com = (TCCR2A >> COM2B0) & 0x03;
+    if (wgm == 2 && com == 1) {
+        return 2 * timer2Period();
+    }
+    if ((wgm == 3 || wgm == 7) && com >= 2) {
+        return timer2Period();
+    }
+    return 0;
+}
+
+/**
+    Move the virtual clock to a later cycle, counting the PCLK cycles run on the way. A cycle
+    in progress when the period is shortened, as when Timer2 is restarted, ends within the
+    new period.
+*/
+static void runClock(uint64_t to) {
+    uint32_t period = pclkPeriod();
+    if (period) {
+        uint64_t part = (pclkPart < period ? pclkPart : period - 1) + (to - cycles);
+        pclkCycles += part / period;
+        pclkPart = part % period;
+    }
+    cycles = to;
+}
+
+/**
+    Run an interrupt handler with the I bit cleared
+*/
+static void runIsr(void (*vector)(void)) {
+    if (vector == NULL) {
+        return;
+    }
+    inIsr = true;
+    SREG.value &= ~(1 << SREG_I);
+    vector();
+    SREG.value |= (1 << SREG_I);
+    inIsr = false;
+}
+
+/**
+    Move a timer's next boundary past now. Returns true if a boundary was crossed.
+*/
+static bool timerDue(uint64_t &next, uint32_t period) {
+    if (period == 0) {
+        next = cycles + 1;
+        return false;
+    }
+    if (next > cycles) {
+        return false;
+    }
+    next = cycles - (cycles - next) % period + period;
+    return true;
+}
+
+/**
+    Earliest boundary of the running timers
+*/
+static uint64_t nextEvent() {
+    uint64_t next = timer0Next;
+    if (timer1Period() && timer1Next < next) {
+        next = timer1Next;
+    }
+    if (timer2Period() && timer2Next < next) {
+        next = timer2Next;
+    }
+    return next;
+}
+
+void hostPoll() {
+    if (inIsr || !(SREG.value & (1 << SREG_I))) {
+        return;
+    }
+    if (timerDue(timer0Next, TIMER0_PERIOD)) {
+        if (TIMSK0 & (1 << OCIE0A)) {
+            runIsr(TIMER0_COMPA_vect);
+        }
+        if (TIMSK0 & (1 << OCIE0B)) {
+            runIsr(TIMER0_COMPB_vect);
+        }
+    }
+    if (timerDue(timer1Next, timer1Period()) && (TIMSK1 & (1 << TOIE1))) {
+        runIsr(TIMER1_OVF_vect);
+    }
+    if (timerDue(timer2Next, timer2Period())) {
+        if (TIMSK2 & (1 << OCIE2A)) {
+            runIsr(TIMER2_COMPA_vect);
+        }
+        if (TIMSK2 & (1 << OCIE2B)) {
+            runIsr(TIMER2_COMPB_vect);
+        }
+    }
+}
+
+uint64_t hostCycles() {
+    return cycles;
+}
+
+void hostAdvance(uint32_t count) {
+    uint64_t target = cycles + count;
+    hostPoll();
+    while (cycles < target) {
+
+        // Boundaries are only brought up to date while interrupts are enabled
+        uint64_t next = nextEvent();
+        runClock((next > cycles && next < target) ? next : target);
+        hostPoll();
+    }
+}
+
+void hostReset() {
+    cycles = 0;
+    pclkCycles = 0;
+    pclkPart = 0;
+    inIsr = false;
+    timer0Next = TIMER0_PERIOD;
+    timer1Next = 0;
+    timer2Next = 0;
+    HostPort *ports[] = {&PORTB, &PORTC, &PORTD};
+    for (HostPort *port : ports) {
+        port->out = 0;
+        port->in = 0;
+        port->ddr = 0;
+    }
+    SREG.value = 1 << SREG_I;
+    TCCR0A = TCCR0B = TCNT0 = OCR0A = OCR0B = TIMSK0 = TIFR0 = 0;
+    TCCR1A = TCCR1B = TCCR1C = TIMSK1 = TIFR1 = 0;
+    TCNT1 = OCR1A = OCR1B = ICR1 = 0;
+    TCCR2A = TCCR2B = TCNT2 = OCR2A = OCR2B = TIMSK2 = TIFR2 = 0;
+}
+
+uint32_t hostPclkHz() {
+    uint32_t period = pclkPeriod();
+    return period ? F_CPU / period : 0;
+}
+
+uint64_t hostPclkCycles() {
+    return pclkCycles;
+}
+
+/**
+    Port write. Costs one cycle, like an out instruction.
+*/
+HostPort &HostPort::operator=(uint8_t value) {
+    this->out = value;
+    runClock(cycles + 1);
+    for (HostPortListener *listener : this->listeners) {
+        if (listener) {
+            listener->portWrite(value);
+        }
+    }
+    return *this;
+}
+
+void HostPort::attach(HostPortListener *listener) {
+    for (HostPortListener *&slot : this->listeners) {
+        if (slot == NULL) {
+            slot = listener;
+            return;
+        }
+    }
+}
+
+void HostPort::detach(HostPortListener *listener) {
+    for (HostPortListener *&slot : this->listeners) {
+        if (slot == listener) {
+            slot = NULL;
+        }
+    }
+}
+
+HostSreg &HostSreg::operator=(uint8_t value) {
+    this->value = value;
+    runClock(cycles + 1);
+    hostPoll();
+    return *this;
+}
+
+/**
+    Port and bit of an Arduino pin number
+*/
+static HostPort *pinPort(uint8_t pin, uint8_t &bit) {
+    if (pin < 8) {
+        bit = pin;
+        return &PORTD;
+    }
+    if (pin < 14) {
+        bit = pin - 8;
+        return &PORTB;
+    }
+    if (pin < 20) {
+        bit = pin - 14;
+        return &PORTC;
+    }
+    return NULL;
+}
+
+void pinMode(uint8_t pin, uint8_t mode) {
+    uint8_t bit;
+    HostPort *port = pinPort(pin, bit);
+    if (port == NULL) {
+        return;
+    }
+    if (mode == OUTPUT) {
+        port->ddr |= (1 << bit);
+    }
+    else {
+        port->ddr &= ~(1 << bit);
+    }
+}
+
+void digitalWrite(uint8_t pin, uint8_t val) {
+    uint8_t bit;
+    HostPort *port = pinPort(pin, bit);
+    if (port == NULL) {
+        return;
+    }
+    if (val) {
+        *port |= (1 << bit);
+    }
+    else {
+        *port &= ~(1 << bit);
+    }
+}
+
+int digitalRead(uint8_t pin) {
+    uint8_t bit;
+    HostPort *port = pinPort(pin, bit);
+    if (port == NULL) {
+        return LOW;
+    }
+    return (port->pins() >> bit) & 1;
+}
+
+// External interrupt pins are not modelled
+void attachInterrupt(uint8_t, void (*)(void), int) {
+}
+
+void delay(unsigned long ms) {
+    while (ms--) {
+        hostAdvance(F_CPU / 1000);
+    }
+}
+
+// The count is an unsigned int, 16 bits on the AVR
+void delayMicroseconds(unsigned int us) {
+    hostAdvance((uint16_t)us * (F_CPU / 1000000));
+}
+
+// Both wrap at 32 bits as on the AVR, whatever the size of a host unsigned long
+unsigned long millis(void) {
+    return (uint32_t)(cycles / (F_CPU / 1000));
+}
+
+unsigned long micros(void) {
+    return (uint32_t)(cycles / (F_CPU / 1000000));
+}
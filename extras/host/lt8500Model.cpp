@@ -0,0 +1,330 @@
+/******************************************************************************
+    This file is the LT8500 model of the host build of the Data-Vu evaluation
+    kit library created by Plessey Semiconductors.
+
+    Copyright (C) 2019  <Gethn Pickard>
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <https://www.gnu.org/licenses/>.
+******************************************************************************/
+
+#include "lt8500Model.h"
+#include "dataVuHost.h"
+
+/**
+    Class constructor. Listens to the SDI, SCKI and LATCH bits of port and drives sdoBit of
+    the port's input register with the last chip's serial output, if given.
+*/
+LT8500Chain::LT8500Chain(HostPort &port, uint8_t sdiBit, uint8_t sckiBit, uint8_t latchBit, uint8_t chips, int8_t sdoBit)
+    : port(port), chips(chips), shift(chips * LT8500_FRAME_BITS, 0) {
+
+    this->sdi = 1 << sdiBit;
+    this->scki = 1 << sckiBit;
+    this->latch = 1 << latchBit;
+    this->sdo = sdoBit < 0 ? 0 : 1 << sdoBit;
+    this->head = 0;
+    this->prev = port.out;
+    this->latchStart = 0;
+    this->resetPclk = 0;
+    this->reset();
+    this->clearStats();
+    port.attach(this);
+}
+
+LT8500Chain::~LT8500Chain() {
+    this->port.detach(this);
+}
+
+/**
+    Follow the serial pins after a port write
+*/
+void LT8500Chain::portWrite(uint8_t value) {
+
+    uint8_t rise = value & ~this->prev;
+    uint8_t fall = ~value & this->prev;
+    this->prev = value;
+
+    // Data is sampled on the rising edge of SCKI
+    if (rise & this->scki) {
+        if (this->frameBits == 0) {
+            this->frameStart = hostCycles();
+        }
+        uint8_t bit = (value & this->sdi) ? 1 : 0;
+        if (this->bits + 1 == this->glitchBit) {
+            bit ^= 1;
+        }
+        this->shiftIn(bit);
+    }
+
+    if (rise & this->latch) {
+        this->latchStart = hostCycles();
+    }
+
+    // A long LATCH pulse resets the chips, a short one runs the latched commands
+    if (fall & this->latch) {
+        uint64_t now = hostCycles();
+        if (now - this->latchStart >= LT8500_RESET_CYCLES) {
+            this->reset();
+            this->resets++;
+            this->resetPclk = hostPclkCycles();
+        }
+        else {
+            if (this->frameBits == 0 || this->frameBits % this->shift.size() != 0) {
+                this->frameErrors++;
+            }
+            this->runCommands();
+            this->loadStatus();
+            
+            // Position in the PWM period, counted in PCLK cycles since the reset
+            this->latchPhase = (hostPclkCycles() - this->resetPclk) % LT8500_PWM_PERIOD;
+            uint8_t cmd = this->chips[0].lastCommand;
+            if (cmd == LT8500_CMD_SYNC_UPDATE && this->latchPhase >= LT8500_PWM_PERIOD - LT8500_SYNC_WINDOW) {
+                this->boundaryLatches++;
+            }
+            this->latches++;
+            this->lastFrameCycles = this->frameBits ? now - this->frameStart : 0;
+            this->lastLatchCycle = now;
+            if (this->firstLightCycle == 0 && this->lit()) {
+                this->firstLightCycle = now;
+            }
+        }
+        this->frameBits = 0;
+    }
+}
+
+/**
+    Number of chips in the chain
+*/
+uint8_t LT8500Chain::chipCount() const {
+    return this->chips.size();
+}
+
+/**
+    Registers of chip n, 0 is the chip nearest the MCU
+*/
+const LT8500 &LT8500Chain::chip(uint8_t n) const {
+    return this->chips[n];
+}
+
+/**
+    PWM register of a channel numbered along the chain, chip 0 has channels 0 to 47
+*/
+uint16_t LT8500Chain::pwm(uint16_t channel) const {
+    return this->chips[channel / LT8500_CHANNELS].pwm[channel % LT8500_CHANNELS];
+}
+
+/**
+    Correction register of a channel numbered along the chain
+*/
+uint8_t LT8500Chain::correction(uint16_t channel) const {
+    return this->chips[channel / LT8500_CHANNELS].correction[channel % LT8500_CHANNELS];
+}
+
+/**
+    Output duty cycle of a channel between 0 and 1. Correction scales the PWM value by
+    (correction + 1) / 64 when enabled.
+*/
+float LT8500Chain::duty(uint16_t channel) const {
+    const LT8500 &c = this->chips[channel / LT8500_CHANNELS];
+    if (not c.outputEnabled) {
+        return 0;
+    }
+    float d = this->pwm(channel) / 4096.0f;
+    if (c.correctionEnabled) {
+        d *= (this->correction(channel) + 1) / 64.0f;
+    }
+    return d;
+}
+
+/**
+    True if any channel has its output enabled and a non zero PWM value
+*/
+bool LT8500Chain::lit() const {
+    for (const LT8500 &c : this->chips) {
+        if (c.outputEnabled) {
+            for (int i = 0; i < LT8500_CHANNELS; i++) {
+                if (c.pwm[i]) {
+                    return true;
+                }
+            }
+        }
+    }
+    return false;
+}
+
+/**
+    Disconnect the LED of a channel numbered along the chain, found by the next self test
+*/
+void LT8500Chain::setLedOpen(uint16_t channel, bool open) {
+    this->chips[channel / LT8500_CHANNELS].ledOpen[channel % LT8500_CHANNELS] = open;
+}
+
+/**
+    Set the over temperature flag of chip n
+*/
+void LT8500Chain::setOverTemp(uint8_t chip, bool hot) {
+    this->chips[chip].overTemp = hot;
+}
+
+/**
+    Power on state of the chips
+*/
+void LT8500Chain::reset() {
+    for (LT8500 &c : this->chips) {
+        for (int i = 0; i < LT8500_CHANNELS; i++) {
+            c.pwm[i] = 0;
+            c.correction[i] = 0;
+        }
+        c.outputEnabled = false;
+        c.correctionEnabled = true;
+        c.phaseShift = false;
+        c.lastCommand = LT8500_CMD_SYNC_UPDATE;
+        for (int i = 0; i < LT8500_CHANNELS; i++) {
+            c.openFault[i] = false;
+        }
+    }
+    this->frameBits = 0;
+}
+
+/**
+    Clear the statistics
+*/
+void LT8500Chain::clearStats() {
+    this->bits = 0;
+    this->latches = 0;
+    this->resets = 0;
+    this->frameErrors = 0;
+    this->unknownCommands = 0;
+    this->lastFrameCycles = 0;
+    this->lastLatchCycle = 0;
+    this->firstLightCycle = 0;
+    this->glitchBit = 0;
+    this->latchPhase = 0;
+    this->boundaryLatches = 0;
+}
+
+/**
+    Replace each chip's shift register with its status frame
+*/
+void LT8500Chain::loadStatus() {
+    size_t count = this->chips.size();
+    size_t size = this->shift.size();
+    for (size_t n = 0; n < count; n++) {
+        const LT8500 &c = this->chips[n];
+        size_t base = this->head + (count - 1 - n) * LT8500_FRAME_BITS;
+        for (size_t pos = 0; pos < LT8500_FRAME_BITS; pos++) {
+            this->shift[(base + pos) % size] = 0;
+        }
+        for (int i = 0; i < LT8500_CHANNELS; i++) {
+            this->shift[(base + i * 12) % size] = c.openFault[LT8500_CHANNELS - 1 - i];
+        }
+        this->shift[(base + LT8500_FRAME_BITS - 1) % size] = c.overTemp;
+    }
+    this->updateSdo();
+}
+
+/**
+    Bit of the shift register, 0 is the oldest
+*/
+uint8_t LT8500Chain::bitAt(size_t pos) const {
+    return this->shift[(this->head + pos) % this->shift.size()];
+}
+
+/**
+    Field of the shift register starting at pos - MSB first
+*/
+uint16_t LT8500Chain::field(size_t pos, uint8_t width) const {
+    uint16_t value = 0;
+    for (uint8_t i = 0; i < width; i++) {
+        value = (value << 1) | this->bitAt(pos + i);
+    }
+    return value;
+}
+
+/**
+    Clock a bit into the first chip. The oldest bit drops out of the last chip onto SDO.
+*/
+void LT8500Chain::shiftIn(uint8_t bit) {
+    this->shift[this->head] = bit;
+    this->head = (this->head + 1) % this->shift.size();
+    this->bits++;
+    this->frameBits++;
+    this->updateSdo();
+}
+
+/**
+    Run the command in each chip's shift register
+*/
+void LT8500Chain::runCommands() {
+
+    size_t count = this->chips.size();
+    for (size_t n = 0; n < count; n++) {
+
+        // The last chip holds the oldest bits
+        LT8500 &c = this->chips[n];
+        size_t base = (count - 1 - n) * LT8500_FRAME_BITS;
+        uint8_t cmd = this->field(base + LT8500_CHANNELS * 12, 8);
+        c.lastCommand = cmd;
+
+        switch (cmd) {
+            case LT8500_CMD_SYNC_UPDATE:
+            case LT8500_CMD_ASYNC_UPDATE:
+            case LT8500_CMD_UPDATE_CORRECTION:
+                for (int i = 0; i < LT8500_CHANNELS; i++) {
+                    uint16_t data = this->field(base + i * 12, 12);
+                    uint8_t channel = LT8500_CHANNELS - 1 - i;
+                    if (cmd == LT8500_CMD_UPDATE_CORRECTION) {
+                        c.correction[channel] = data >> 6;
+                    }
+                    else {
+                        c.pwm[channel] = data;
+                    }
+                }
+                break;
+            case LT8500_CMD_OUTPUT_ENABLE:
+                c.outputEnabled = true;
+                break;
+            case LT8500_CMD_OUTPUT_DISABLE:
+                c.outputEnabled = false;
+                break;
+            case LT8500_CMD_SELF_TEST:
+                for (int i = 0; i < LT8500_CHANNELS; i++) {
+                    c.openFault[i] = c.ledOpen[i];
+                }
+                break;
+            case LT8500_CMD_TOGGLE_PHASE_SHIFT:
+                c.phaseShift = not c.phaseShift;
+                break;
+            case LT8500_CMD_TOGGLE_CORRECTION:
+                c.correctionEnabled = not c.correctionEnabled;
+                break;
+            default:
+                this->unknownCommands++;
+                break;
+        }
+    }
+}
+
+/**
+    Drive SDO with the bit that will drop out of the chain next
+*/
+void LT8500Chain::updateSdo() {
+    if (this->sdo) {
+        if (this->bitAt(0)) {
+            this->port.in |= this->sdo;
+        }
+        else {
+            this->port.in &= ~this->sdo;
+        }
+    }
+}
@@ -0,0 +1,140 @@
+/******************************************************************************
+    This file is the header file for the LT8500 model of the host build of the
+    Data-Vu evaluation kit library created by Plessey Semiconductors.
+
+    Copyright (C) 2019  <Gethn Pickard>
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <https://www.gnu.org/licenses/>.
+******************************************************************************/
+
+/*
+    Behavioural model of a daisy chain of LT8500 PWM drivers on one port. Each chip has a
+    584 bit shift register: 48 twelve bit values, channel 47 first and MSB first, followed
+    by an eight bit command. Bits are taken from SDI on each rising edge of SCKI and move
+    along the chain, so the first bits of a frame end up in the last chip. When LATCH falls
+    each chip runs the command in its shift register and loads its status frame into it: the
+    open LED flag of each channel from the last self test in the MSB of its twelve bit field,
+    and LT8500_STATUS_OT in place of the command. Holding LATCH high for LT8500_RESET_CYCLES
+    or more resets the chips instead.
+
+    SDO, if given, follows the oldest bit of the last chip. Open LEDs and over temperature are
+    injected with setLedOpen and setOverTemp, and are kept over a reset.
+
+    Timing is taken from the host virtual clock so the model can report how long frames
+    took to shift.
+*/
+
+#ifndef LT8500_MODEL_H
+#define LT8500_MODEL_H
+
+#include <stdint.h>
+#include <vector>
+#include "Arduino.h"
+
+#define LT8500_CHANNELS     48
+#define LT8500_FRAME_BITS   (LT8500_CHANNELS * 12 + 8)
+
+// LT8500 commands
+#define LT8500_CMD_SYNC_UPDATE          0x00
+#define LT8500_CMD_ASYNC_UPDATE         0x10
+#define LT8500_CMD_UPDATE_CORRECTION    0x20
+#define LT8500_CMD_OUTPUT_ENABLE        0x30
+#define LT8500_CMD_OUTPUT_DISABLE       0x40
+#define LT8500_CMD_SELF_TEST            0x50
+#define LT8500_CMD_TOGGLE_PHASE_SHIFT   0x60
+#define LT8500_CMD_TOGGLE_CORRECTION    0x70
+
+// Status frame
+#define LT8500_STATUS_OPEN  0x800
+#define LT8500_STATUS_OT    0x01
+
+// PWM period in PCLK cycles, and the time before its end in which a synchronous update may
+// be applied at either boundary
+#define LT8500_PWM_PERIOD   4096
+#define LT8500_SYNC_WINDOW  32
+
+// LATCH high time that resets the chips, 1ms at 16MHz
+#define LT8500_RESET_CYCLES (F_CPU / 1000)
+
+// Register state of one chip
+struct LT8500
+{
+    uint16_t pwm[LT8500_CHANNELS];
+    uint8_t correction[LT8500_CHANNELS];
+    bool outputEnabled;
+    bool correctionEnabled;
+    bool phaseShift;
+    uint8_t lastCommand;
+    bool openFault[LT8500_CHANNELS];    // Open LEDs found by the last self test
+
+    // Injected faults
+    bool ledOpen[LT8500_CHANNELS];
+    bool overTemp;
+};
+
+class LT8500Chain : public HostPortListener
+{
+    public:
+
+        // Statistics since the last clearStats
+        unsigned long bits;             // SCKI rising edges
+        unsigned long latches;          // Commands run
+        unsigned long resets;           // Long LATCH pulses
+        unsigned long frameErrors;      // Latches after a bit count that is not whole frames
+        unsigned long unknownCommands;  // Latched command bytes the model does not know
+        uint64_t lastFrameCycles;       // First SCKI edge to LATCH of the last frame
+        uint64_t lastLatchCycle;        // Virtual clock at the last latch
+        uint64_t firstLightCycle;       // Virtual clock at the first latch that lit a channel
+        uint16_t latchPhase;            // PCLK cycles into the PWM period at the last latch
+        unsigned long boundaryLatches;  // PWM updates latched in the LT8500_SYNC_WINDOW
+
+        // SDI bit inverted as it is shifted in, counted in bits since clearStats. 0 for none.
+        unsigned long glitchBit;
+
+        LT8500Chain(HostPort &port, uint8_t sdiBit, uint8_t sckiBit, uint8_t latchBit, uint8_t chips = 2, int8_t sdoBit = -1);
+        ~LT8500Chain();
+        void portWrite(uint8_t value);
+
+        uint8_t chipCount() const;
+        const LT8500 &chip(uint8_t n) const;
+        uint16_t pwm(uint16_t channel) const;
+        uint8_t correction(uint16_t channel) const;
+        float duty(uint16_t channel) const;
+        bool lit() const;
+        void setLedOpen(uint16_t channel, bool open);
+        void setOverTemp(uint8_t chip, bool hot);
+        void reset();
+        void clearStats();
+
+    private:
+        HostPort &port;
+        uint8_t sdi, scki, latch, sdo;
+        std::vector<LT8500> chips;
+        std::vector<uint8_t> shift;     // Shift register bits, oldest at head
+        size_t head;
+        unsigned long frameBits;        // Bits since the last latch
+        uint64_t frameStart;
+        uint64_t latchStart;
+        uint64_t resetPclk;             // PWM periods are counted in PCLK from the end of a reset
+        uint8_t prev;
+
+        uint8_t bitAt(size_t pos) const;
+        uint16_t field(size_t pos, uint8_t width) const;
+        void shiftIn(uint8_t bit);
+        void runCommands();
+        void loadStatus();
+        void updateSdo();
+};
+
+#endif //LT8500_MODEL_H